@@ -11,9 +11,21 @@
 #pragma once
 #include <nats.h>
 #include <string>
+#include <string_view>
+#include <span>
+#include <cstddef>
 #include <list>
 #include <future>
-#include <queue>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <memory_resource>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <unordered_map>
 
 namespace CppNats {
 
@@ -50,7 +62,8 @@ namespace CppNats {
         NotInitialized = NATS_NOT_INITIALIZED,
         SslError = NATS_SSL_ERROR,
         NoServerSupport = NATS_NO_SERVER_SUPPORT,
-        NotYetConnected = NATS_NOT_YET_CONNECTED
+        NotYetConnected = NATS_NOT_YET_CONNECTED,
+        NoResponders = NATS_NO_RESPONDERS
     };
 
     enum class ConnectionStatus : short
@@ -64,6 +77,14 @@ namespace CppNats {
         DrainingPubs = NATS_CONN_STATUS_DRAINING_PUBS
     };
 
+    // Connection event callbacks, see Options::setDisconnectedHandler() and others.
+    // They run on a cnats thread and must not block it for long.
+    using ConnectionHandler = std::function<void()>;
+    // Asynchronous errors, e.g. Status::SlowConsumer or a failed write.
+    using ConnectionErrorHandler = std::function<void(Status status)>;
+    // Flow-control signal, see Options::setWriteWatermarks().
+    using WatermarkHandler = std::function<void(bool above)>;
+
     class Exception : public std::exception
     {
     public:
@@ -72,6 +93,171 @@ namespace CppNats {
         const char* what() const noexcept override { return natsStatus_GetText(errorCode); }
     };
     
+    // Components of a server URL such as "nats://user:pass@[::1]:4222". The views
+    // point into the parsed string. parse() does not allocate and is constexpr, so
+    // literals can be checked at compile time:
+    //     static_assert(ServerUrl::parse("nats://localhost:4222"));
+    struct ServerUrl
+    {
+        // nats, tls, nats-tls, ws or wss, in any case
+        std::string_view scheme;
+        // user name, or token when there is no password
+        std::string_view user;
+        std::string_view password;
+        // IPv6 literals without their brackets
+        std::string_view host;
+        // 0 when not given
+        uint16_t port = 0;
+        // ws and wss only
+        std::string_view path;
+
+        static constexpr std::optional<ServerUrl> parse(std::string_view url) noexcept
+        {
+            ServerUrl result;
+            auto sep = url.find("://");
+            if (sep == std::string_view::npos) {
+                return std::nullopt;
+            }
+            result.scheme = url.substr(0, sep);
+            bool websocket = equalsNoCase(result.scheme, "ws") || equalsNoCase(result.scheme, "wss");
+            if (!websocket && !equalsNoCase(result.scheme, "nats") && !equalsNoCase(result.scheme, "tls") &&
+                !equalsNoCase(result.scheme, "nats-tls")) {
+                return std::nullopt;
+            }
+            auto authority = url.substr(sep + 3);
+            auto slash = authority.find('/');
+            if (slash != std::string_view::npos) {
+                result.path = authority.substr(slash);
+                authority = authority.substr(0, slash);
+                if (!websocket || !printable(result.path)) {
+                    return std::nullopt;
+                }
+            }
+            auto at = authority.rfind('@');
+            if (at != std::string_view::npos) {
+                auto credentials = authority.substr(0, at);
+                authority = authority.substr(at + 1);
+                auto colon = credentials.find(':');
+                result.user = credentials.substr(0, colon);
+                if (colon != std::string_view::npos) {
+                    result.password = credentials.substr(colon + 1);
+                }
+                if (result.user.empty() || !printable(credentials)) {
+                    return std::nullopt;
+                }
+            }
+            std::string_view port;
+            if (!authority.empty() && authority.front() == '[') {
+                auto close = authority.find(']');
+                if (close == std::string_view::npos) {
+                    return std::nullopt;
+                }
+                result.host = authority.substr(1, close - 1);
+                port = authority.substr(close + 1);
+                if (!ipv6(result.host)) {
+                    return std::nullopt;
+                }
+            } else {
+                auto colon = authority.find(':');
+                result.host = authority.substr(0, colon);
+                port = colon == std::string_view::npos ? std::string_view() : authority.substr(colon);
+                if (!hostname(result.host)) {
+                    return std::nullopt;
+                }
+            }
+            if (!port.empty()) {
+                // an empty port ("host:") means the default one
+                if (port.front() != ':' || port.size() > 6) {
+                    return std::nullopt;
+                }
+                uint32_t value = 0;
+                for (char c : port.substr(1)) {
+                    if (c < '0' || c > '9') {
+                        return std::nullopt;
+                    }
+                    value = value * 10 + static_cast<uint32_t>(c - '0');
+                }
+                if (value > 65535) {
+                    return std::nullopt;
+                }
+                result.port = static_cast<uint16_t>(value);
+            }
+            return result;
+        }
+
+    private:
+        static constexpr bool equalsNoCase(std::string_view a, std::string_view b) noexcept
+        {
+            if (a.size() != b.size()) {
+                return false;
+            }
+            for (std::size_t i = 0; i < a.size(); ++i) {
+                char c = a[i] >= 'A' && a[i] <= 'Z' ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+                if (c != b[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static constexpr bool printable(std::string_view str) noexcept
+        {
+            for (char c : str) {
+                if (static_cast<unsigned char>(c) <= ' ' || c == 0x7f) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static constexpr bool alnum(char c) noexcept
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+        }
+
+        // RFC 1123 host name (which includes dotted IPv4 addresses)
+        static constexpr bool hostname(std::string_view host) noexcept
+        {
+            if (host.empty() || host.size() > 253) {
+                return false;
+            }
+            std::size_t label = 0;
+            for (std::size_t i = 0; i < host.size(); ++i) {
+                char c = host[i];
+                if (c == '.') {
+                    if (label == 0 || host[i - 1] == '-') {
+                        return false;
+                    }
+                    label = 0;
+                } else if (alnum(c) || (c == '-' && label > 0)) {
+                    if (++label > 63) {
+                        return false;
+                    }
+                } else {
+                    return false;
+                }
+            }
+            return label > 0 && host.back() != '-';
+        }
+
+        static constexpr bool ipv6(std::string_view host) noexcept
+        {
+            int colons = 0;
+            for (char c : host) {
+                if (c == ':') {
+                    ++colons;
+                } else if (!(alnum(c) && (c <= '9' || (c | 0x20) <= 'f')) && c != '.') {
+                    return false;
+                }
+            }
+            auto compressed = host.find("::");
+            if (compressed != std::string_view::npos && host.find("::", compressed + 1) != std::string_view::npos) {
+                return false;
+            }
+            return colons >= 2 && colons <= 7;
+        }
+    };
+
     /* For advanced configuration, create a Options object before connecting:
         Options opts;
         opts.timeout(5000);
@@ -83,6 +269,18 @@ namespace CppNats {
     {
         private:
             natsOptions* natsOpts;
+            // receive-side payload pool, see setPayloadPool()
+            bool payloadPool = false;
+            std::pmr::pool_options payloadPoolOptions;
+            // kept for Client::reconnectBufferSize()
+            int reconnectBufSize = 8 * 1024 * 1024;
+            ConnectionHandler disconnectedHandler;
+            ConnectionHandler reconnectedHandler;
+            ConnectionHandler closedHandler;
+            ConnectionErrorHandler errorHandler;
+            std::size_t highWatermark = 0;
+            std::size_t lowWatermark = 0;
+            WatermarkHandler watermarkHandler;
             friend class Client;
 
         public:
@@ -90,6 +288,8 @@ namespace CppNats {
             // create an Options object and pass it to connect() without setting any option if they don't want to.
             Options();
             ~Options();
+            Options(const Options&) = delete;
+            Options& operator=(const Options&) = delete;
 
             enum class IPResolutionOrder : short
             {
@@ -145,74 +345,1047 @@ namespace CppNats {
             void loadCertificates(const std::string& certFile, const std::string& keyFile, const std::string& caFile);
             #endif
 
+            // ----------- Memory Configuration -----------
+            // PayloadPool: give each subscription its own recycling pool for the payload copies made by
+            // the application (see Subscription::payloadPool()). largestBlock is the largest copy served
+            // from the pool (bigger ones go to the heap), blocksPerChunk how many blocks are carved at once
+            // (0 lets the pool decide). Disabled by default.
+            void setPayloadPool(std::size_t largestBlock, std::size_t blocksPerChunk = 0);
+
             // ----------- Callback and Event Configuration -----------
-            // Set callback functions for connection events (e.g., disconnect, reconnect, error)    
-            //void setDisconnectHandler(void (*handler)(natsConnection* nc, void* closure), void* closure);
-            //void setReconnectHandler(void (*handler)(natsConnection* nc, void* closure), void* closure);
-            //void setErrorHandler(void (*handler)(natsConnection* nc, natsStatus err, const char* errTxt, void* closure), void* closure);
-            //void setClosedHandler(void (*handler)(natsConnection* nc, void* closure), void* closure);
+            // Callbacks for connection events. While disconnected, publishes are held in the
+            // reconnect buffer: a producer can watch Client::buffered() from the disconnected
+            // handler until the reconnected one, instead of overflowing it.
+            // Exceptions thrown by a handler are ignored.
+            void setDisconnectedHandler(ConnectionHandler handler);
+            void setReconnectedHandler(ConnectionHandler handler);
+            // Called once the connection is closed for good, as its last event.
+            void setClosedHandler(ConnectionHandler handler);
+            void setErrorHandler(ConnectionErrorHandler handler);
+            // Lets producers throttle themselves before the write deadline (see setWriteDeadline())
+            // disconnects a slow connection: handler(true) is called by the publish that brings
+            // Client::buffered() to high bytes or more, handler(false) once they drained to low
+            // bytes, from the client's timer thread (or by close() if still above then). Calls
+            // alternate, and the handler may publish but must not close the client.
+            // Requires 0 < low < high. Disabled by default.
+            void setWriteWatermarks(std::size_t high, std::size_t low, WatermarkHandler handler);
     }; 
 
+    // A subject validated once and interned, for subjects used over and over:
+    //     const Subject orders("orders.eu");
+    //     client.publish(orders, payload);
+    // Equal subjects share one NUL-terminated string that lives until the end of the
+    // program, so copying a Subject is copying a pointer, comparing two of them
+    // compares pointers, and the hash used by ClientPool is computed once.
+    // Throws Exception(NATS_INVALID_SUBJECT) on an empty token, whitespace, or a
+    // wildcard that is not a whole token ('>' only as the last one).
+    class Subject
+    {
+    private:
+        const char* m_str;
+        std::size_t m_size;
+        std::size_t m_hash;
+        bool m_wildcard;
+
+    public:
+        explicit Subject(std::string_view subject);
+
+        std::string_view str() const noexcept { return std::string_view(m_str, m_size); }
+        const char* c_str() const noexcept { return m_str; }
+        std::size_t size() const noexcept { return m_size; }
+        // Same value as std::hash<std::string_view> on str().
+        std::size_t hash() const noexcept { return m_hash; }
+        // Contains '*' or '>': valid for subscribing, not for publishing.
+        bool wildcard() const noexcept { return m_wildcard; }
+
+        bool operator==(const Subject& other) const noexcept { return m_str == other.m_str; }
+    };
+
+    // A Message owns exactly one natsMsg and is move-only: moving transfers the
+    // natsMsg pointer, so views taken before the move remain valid on the target.
+    // Use clone() when a second, independent copy is really needed.
     class Message
     {
     private:
         natsMsg* m_msg;
-        void setMsg(natsMsg* msg) { m_msg = msg; }
+        void setMsg(natsMsg* msg) noexcept;
     public:
         Message();
         Message(const std::string& subject, const std::string& data, const std::string& reply = "");
+        // Throws Exception(NATS_INVALID_SUBJECT) if subject has a wildcard.
+        Message(const Subject& subject, std::string_view data);
+        // Takes ownership of a natsMsg (e.g. one delivered by cnats).
+        explicit Message(natsMsg* msg) noexcept : m_msg(msg) {}
         ~Message() noexcept;
 
+        Message(const Message&) = delete;
+        Message& operator=(const Message&) = delete;
+        Message(Message&& other) noexcept : m_msg(other.m_msg) { other.m_msg = nullptr; }
+        Message& operator=(Message&& other) noexcept;
+
+        // Deep copy of subject, reply and data into a new natsMsg.
+        Message clone() const;
+        // Gives up ownership of the natsMsg, the caller must destroy it.
+        natsMsg* release() noexcept;
+        bool empty() const noexcept { return m_msg == nullptr; }
+
         natsMsg* getNatsMsg() const { return m_msg; }   
         void setSubject(const std::string& subject);
         void setData(const std::string& data);
         void setReply(const std::string& reply);
-        const std::string subject() const;
-        const std::string data() const;
-        const std::string reply() const;
-        
-        bool operator==(const Message &other) const;
+
+        // Views borrow directly from the natsMsg buffer: no allocation, no copy.
+        // They stay valid as long as this Message owns the underlying natsMsg,
+        // and are invalidated by any setter or by the destruction of the Message.
+        // An empty Message (or an unset reply) yields an empty view.
+        std::string_view subject() const noexcept;
+        std::string_view data() const noexcept;
+        std::string_view reply() const noexcept;
+        std::span<const std::byte> bytes() const noexcept;
+
+        // Owning copies, for when the content must outlive the Message.
+        std::string subjectCopy() const;
+        std::string dataCopy() const;
+        std::string replyCopy() const;
+        // Same, allocated from resource (e.g. Subscription::payloadPool()).
+        std::pmr::string subjectCopy(std::pmr::memory_resource* resource) const;
+        std::pmr::string dataCopy(std::pmr::memory_resource* resource) const;
+        std::pmr::string replyCopy(std::pmr::memory_resource* resource) const;
+
+        // Headers. Reads return views into the natsMsg, like the fields above; a
+        // missing header yields an empty view. Setters keep the other headers, and
+        // so do setSubject()/setData()/setReply() and clone().
+        std::string_view header(std::string_view key) const;
+        bool hasHeader(std::string_view key) const;
+        // Calls f(key, value) for every value of every header, without building a container.
+        template<typename F>
+        void forEachHeader(F&& f) const;
+        // Replaces all values of key.
+        void setHeader(std::string_view key, std::string_view value);
+        // Adds a value to key.
+        void addHeader(std::string_view key, std::string_view value);
+        void removeHeader(std::string_view key);
+
+        // Field-wise comparison on views, never allocates.
+        bool operator==(const Message &other) const noexcept;
 
         friend class Client;
     };
 
-    typedef std::queue<Message> QMessages; 
+    template<typename F>
+    void Message::forEachHeader(F&& f) const
+    {
+        const char** keys = nullptr;
+        int keyCount = 0;
+        // the arrays are allocated by cnats, the strings belong to the message
+        if (!m_msg || natsMsgHeader_Keys(m_msg, &keys, &keyCount) != NATS_OK) {
+            return;
+        }
+        for (int i = 0; i < keyCount; ++i) {
+            const char** values = nullptr;
+            int valueCount = 0;
+            if (natsMsgHeader_Values(m_msg, keys[i], &values, &valueCount) != NATS_OK) {
+                continue;
+            }
+            for (int j = 0; j < valueCount; ++j) {
+                f(std::string_view(keys[i]), std::string_view(values[j]));
+            }
+            std::free(values);
+        }
+        std::free(keys);
+    }
+
+    // Snapshot of a connection's counters, see Client::stats().
+    struct ClientStats
+    {
+        uint64_t inMsgs = 0;
+        uint64_t inBytes = 0;
+        uint64_t outMsgs = 0;
+        uint64_t outBytes = 0;
+        uint64_t reconnects = 0;
+
+        // Prometheus text exposition format, metric names start with prefix.
+        std::string toPrometheus(std::string_view prefix = "cppnats") const;
+    };
+
+    // Snapshot of a subscription's counters, see Subscription::stats().
+    struct SubscriptionStats
+    {
+        std::string subject;
+        // messages/bytes received by cnats but not yet handed to the subscription
+        int64_t pendingMsgs = 0;
+        int64_t pendingBytes = 0;
+        int64_t maxPendingMsgs = 0;
+        int64_t maxPendingBytes = 0;
+        int64_t delivered = 0;
+        // dropped by cnats because its pending limits were reached
+        int64_t droppedMsgs = 0;
+        // delivery queue, summed over the workers of a handler subscription
+        // (empty for handler subscriptions without workers)
+        uint64_t queueDepth = 0;
+        uint64_t queueHighWater = 0;
+        uint64_t queueCapacity = 0;
+        uint64_t queueDropped = 0;
+
+        // Prometheus text exposition format, labelled with the subject.
+        std::string toPrometheus(std::string_view prefix = "cppnats") const;
+    };
+
+    // Prometheus text exposition of several subscriptions for one scrape: the TYPE line
+    // of each metric family is written once, followed by a sample per subscription.
+    std::string toPrometheus(std::span<const SubscriptionStats> stats, std::string_view prefix = "cppnats");
+
+    // What a full delivery queue does with the next message.
+    enum class OverflowPolicy : short
+    {
+        DropNewest,  // the incoming message is dropped
+        DropOldest,  // the oldest queued message is evicted to make room
+        Block        // the delivery thread waits for the application to make room,
+                     // letting messages build up in cnats' pending limits instead
+    };
+
+    // Invoked once each time a subscription starts losing (or, with OverflowPolicy::Block,
+    // holding back) messages, with the counters at that moment. It runs on a cnats thread.
+    using SlowConsumerHandler = std::function<void(const SubscriptionStats&)>;
+
+    // How a handler subscription with workers spreads messages over them.
+    enum class DispatchMode : short
+    {
+        BySubject,  // messages with the same subject always go to the same worker, in order
+        RoundRobin  // messages go to each worker in turn, no ordering between them
+    };
+
+    struct SubscribeOptions
+    {
+        // Number of messages the subscription can hold until the application reads them.
+        // Rounded up to a power of two. With workers, this is the size of each worker's queue.
+        std::size_t capacity = 65536;
+        // Handler subscriptions only: number of threads running the handler. 0 runs it
+        // on the cnats delivery thread.
+        std::size_t workers = 0;
+        DispatchMode dispatch = DispatchMode::BySubject;
+        // What to do when the queue is full.
+        OverflowPolicy overflow = OverflowPolicy::DropNewest;
+        // cnats pending limits: messages/bytes received from the server but not yet handed
+        // to the subscription (or its handler). Beyond them cnats drops messages and reports
+        // a slow consumer. 0 keeps the cnats default, -1 means unlimited.
+        int maxPendingMsgs = 0;
+        int maxPendingBytes = 0;
+        SlowConsumerHandler onSlowConsumer;
+    };
+
+    // Invoked on the cnats delivery thread for each message. The message is destroyed
+    // when the handler returns, unless the handler moves it out.
+    // Handlers of one subscription are never invoked concurrently.
+    using MessageHandler = std::function<void(Message&)>;
+
+    class SubscriptionState;
+    class TimerService;
+    class RequestMux;
+    class ConnectionEvents;
+    class FlowControl;
+    struct SubscriptionContext;
+
+    // C++20 awaitables. They are resumed directly from the cnats delivery thread
+    // (or the client's timer thread on timeout), so no thread is blocked while
+    // waiting; keep the work done after resumption short or hand it off.
+    // They must be awaited directly, in the full-expression that creates them.
+
+    // co_await subscription.nextAwait(timeout) yields the next Message.
+    class MessageAwaiter
+    {
+    private:
+        std::shared_ptr<SubscriptionState> m_state;
+        int m_timeout;
+        natsStatus m_status = NATS_OK;
+        MessageAwaiter(std::shared_ptr<SubscriptionState> state, int timeout)
+            : m_state(std::move(state)), m_timeout(timeout) {}
+
+    public:
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        // Throws Exception(NATS_TIMEOUT) if no message arrived in time.
+        Message await_resume();
+
+        friend class Subscription;
+    };
+
+    // Waits for a reply routed through the client's request multiplexer.
+    class ReplyAwaiter
+    {
+    protected:
+        std::shared_ptr<RequestMux> m_mux;
+        std::string_view m_subject;
+        std::span<const std::byte> m_data;
+        int m_timeout;
+        bool m_flush;
+        natsStatus m_status = NATS_OK;
+        Message m_reply;
+        ReplyAwaiter(std::shared_ptr<RequestMux> mux, std::string_view subject,
+                     std::span<const std::byte> data, int timeout, bool flush)
+            : m_mux(std::move(mux)), m_subject(subject), m_data(data), m_timeout(timeout), m_flush(flush) {}
 
+    public:
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+    };
+
+    // co_await client.requestAwait(...) yields the reply Message.
+    class RequestAwaiter : public ReplyAwaiter
+    {
+        using ReplyAwaiter::ReplyAwaiter;
+    public:
+        // Throws like the future returned by Client::requestAsync().
+        Message await_resume();
+
+        friend class Client;
+    };
+
+    // co_await client.flushAwait(timeout) completes once the server has processed
+    // everything published before it.
+    class FlushAwaiter : public ReplyAwaiter
+    {
+        using ReplyAwaiter::ReplyAwaiter;
+    public:
+        void await_resume();
+
+        friend class Client;
+    };
+
+    // Messages delivered by the server are stored in a bounded, per-subscription
+    // lock-free queue until read with nextMessage(). A Subscription is meant to be
+    // consumed by one thread at a time. It is move-only and unsubscribes when destroyed.
     class Subscription
     {
     private:
-        natsSubscription* m_sub;
-        QMessages m_queue;
+        std::shared_ptr<SubscriptionState> m_state;
         
     public:
-        const Message nextMessage(const int timeout=1000);
+        Subscription();
+        ~Subscription() noexcept;
+        Subscription(Subscription&&) noexcept;
+        Subscription& operator=(Subscription&&) noexcept;
+
+        // Waits up to timeout milliseconds for a message.
+        // Throws Exception(NATS_TIMEOUT) if none arrived in time.
+        Message nextMessage(const int timeout=1000);
+        // Waits up to timeout milliseconds for at least one message, then moves every
+        // queued message (up to out.size()) into out in a single operation.
+        // Previous content of out is released. Returns the number of messages
+        // written, 0 if none arrived in time.
+        std::size_t nextBatch(std::span<Message> out, const int timeout=1000);
+        // Coroutine counterpart of nextMessage(), usable as a message stream:
+        //     while (true) { Message msg = co_await sub.nextAwait(5000); ... }
+        MessageAwaiter nextAwait(const int timeout=1000);
+        void unsubscribe() noexcept;
+        // Number of messages dropped because the queue was full.
+        uint64_t dropped() const noexcept;
+        // Queue counters are read from atomics maintained by the delivery thread,
+        // pending counters are queried from cnats.
+        SubscriptionStats stats() const;
+        // Recycling pool for copies of received messages, e.g. msg.dataCopy(sub.payloadPool()),
+        // enabled by Options::setPayloadPool() (the default heap resource otherwise).
+        // It is not synchronized: use it from the thread consuming the subscription (or from its
+        // handler), and release the copies before the Subscription.
+        std::pmr::memory_resource* payloadPool() const noexcept;
 
         friend class Client;
+        friend class RequestMux;
     };
 
+    class PublishBatch;
+    class JetStream;
+    struct JetStreamOptions;
+
     class Client
     {
     private:
         natsConnection* m_conn;
+        std::shared_ptr<ConnectionEvents> m_events;
+        bool m_payloadPool = false;
+        std::pmr::pool_options m_payloadPoolOptions;
+        // shared with subscriptions and the request multiplexer (created on first use)
+        std::mutex m_mutex;
+        std::shared_ptr<TimerService> m_timer;
+        std::shared_ptr<RequestMux> m_mux;
+
+        int m_reconnectBufSize = 8 * 1024 * 1024;
+        // write watermarks, null unless configured
+        std::shared_ptr<FlowControl> m_flow;
+
+        std::shared_ptr<RequestMux> mux();
+        void connect(natsOptions* opts, std::shared_ptr<ConnectionEvents> events);
+        natsStatus send(const char* subject, std::span<const std::byte> data, const char* reply) noexcept;
+        SubscriptionContext subscriptionContext() const;
 
     public:
         Client();
         ~Client() noexcept;
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
 
         void connect(const Options& options);
         void connect(const std::string& address);
         void close() noexcept;
         void publish(const Message& message);
-        //void publish(const std::string& subject, std::byte message);
-        Subscription subscribe(const std::string& subject, const int timeout=1000);
+        // Publish a payload straight from the caller's buffer, without building a natsMsg.
+        void publish(std::string_view subject, std::string_view data);
+        void publish(std::string_view subject, std::span<const std::byte> data);
+        void publish(std::string_view subject, std::string_view data, std::string_view reply);
+        void publish(std::string_view subject, std::span<const std::byte> data, std::string_view reply);
+        // Publishing to a Subject skips the copy of the subject. Throws
+        // Exception(NATS_INVALID_SUBJECT) if it holds a wildcard.
+        void publish(const Subject& subject, std::string_view data);
+        void publish(const Subject& subject, std::span<const std::byte> data);
+        // Same as publish(), returning the failure instead of throwing, e.g.
+        // Status::InsufficientBuffer when the reconnect buffer is full.
+        Status tryPublish(const Message& message) noexcept;
+        Status tryPublish(std::string_view subject, std::string_view data) noexcept;
+        Status tryPublish(std::string_view subject, std::span<const std::byte> data) noexcept;
+        Status tryPublish(const Subject& subject, std::string_view data) noexcept;
+        Status tryPublish(const Subject& subject, std::span<const std::byte> data) noexcept;
+        // Between the high and the low write watermark, see Options::setWriteWatermarks().
+        bool congested() const noexcept;
+        Subscription subscribe(const std::string& subject, const SubscribeOptions& options = SubscribeOptions());
+        Subscription subscribe(const Subject& subject, const SubscribeOptions& options = SubscribeOptions());
+        // Messages are handed to handler as they arrive instead of being queued;
+        // nextMessage()/nextBatch() are not available on such a subscription.
+        Subscription subscribe(const std::string& subject, MessageHandler handler,
+                               const SubscribeOptions& options = SubscribeOptions());
+        Subscription subscribe(const Subject& subject, MessageHandler handler,
+                               const SubscribeOptions& options = SubscribeOptions());
+        // Members of the same queue group share the messages of subject: each one is
+        // delivered to only one of them.
+        Subscription queueSubscribe(const std::string& subject, const std::string& group,
+                                    const SubscribeOptions& options = SubscribeOptions());
+        Subscription queueSubscribe(const std::string& subject, const std::string& group, MessageHandler handler,
+                                    const SubscribeOptions& options = SubscribeOptions());
 
         // A request that expects a reply.
         Message request(const Message& message, int timeout);
         
         // An asynchronous request that expects a reply. 
         // The returned future will be fulfilled when the reply is received or when the timeout expires.
+        // All asynchronous requests of a client share one reply subscription and one timer thread,
+        // so thousands of outstanding requests cost no extra subscription or thread.
+        // The future fails with Exception(NATS_TIMEOUT), Exception(NATS_NO_RESPONDERS)
+        // or Exception(NATS_CONNECTION_CLOSED).
+        std::future<Message> requestAsync(const Message& message, int timeout);
+        std::future<Message> requestAsync(std::string_view subject, std::string_view data, int timeout);
+
+        // Coroutine counterparts of requestAsync() and flush, resumed without any thread waiting:
+        //     Message reply = co_await client.requestAwait(msg, 1000);
+        //     co_await client.flushAwait(1000);
+        // flushAwait() round-trips a message through the client's own inbox, so it
+        // relies on the server echoing messages back (the default).
+        RequestAwaiter requestAwait(const Message& message, int timeout);
+        RequestAwaiter requestAwait(std::string_view subject, std::string_view data, int timeout);
+        FlushAwaiter flushAwait(int timeout);
+        // Waits up to timeout milliseconds until the server has processed everything sent
+        // so far, e.g. so that a subscription is registered before others publish.
+        void flush(int timeout);
+
+        // Counters of the connection, queried from cnats.
+        ClientStats stats() const;
+        // Disconnected before connect().
+        ConnectionStatus status() const;
+        // Bytes published but not written to the socket yet. While reconnecting they are
+        // held in the reconnect buffer, and publishing fails with
+        // Exception(NATS_INSUFFICIENT_BUFFER) once it would exceed reconnectBufferSize().
+        std::size_t buffered() const;
+        // Options::setReconnectBufSize() of the options the client connected with.
+        std::size_t reconnectBufferSize() const noexcept { return static_cast<std::size_t>(m_reconnectBufSize); }
+
+        // Starts an empty batch of messages published together, see PublishBatch.
+        PublishBatch batch();
+
+        // JetStream context on this connection, see JetStream. The client must outlive it.
+        JetStream jetStream();
+        JetStream jetStream(const JetStreamOptions& options);
+
+        friend class PublishBatch;
+
+    };
+
+    // Accumulates messages and publishes them in order with one submit(), followed
+    // by a single flush for the whole burst:
+    //     auto batch = client.batch();
+    //     batch.add("a", payloadA).add("b", payloadB);
+    //     batch.submit(1000);
+    // The single flush is the only saving over a publish() loop: cnats takes no
+    // pre-encoded buffer, so each message is still published on its own, and add()
+    // copies it so the caller's buffers need not outlive the batch.
+    // The buffers are kept across submit() calls, so a batch reused for every burst
+    // does not allocate once it has grown to the burst size.
+    class PublishBatch
+    {
+    private:
+        struct Entry
+        {
+            // offsets in m_arena, subject and reply are NUL-terminated
+            std::size_t subject;
+            std::size_t reply;
+            std::size_t data;
+            std::size_t dataLength;
+            bool hasReply;
+        };
+
+        Client& m_client;
+        std::vector<char> m_arena;
+        std::vector<Entry> m_entries;
+        // first entry not published yet (a failed submit() stops there)
+        std::size_t m_next = 0;
+
+        std::size_t append(const void* data, std::size_t length, bool terminate);
+
+    public:
+        explicit PublishBatch(Client& client) : m_client(client) {}
+
+        PublishBatch& add(std::string_view subject, std::string_view data, std::string_view reply = std::string_view());
+        PublishBatch& add(std::string_view subject, std::span<const std::byte> data,
+                          std::string_view reply = std::string_view());
+
+        // Number of messages not published yet.
+        std::size_t size() const noexcept { return m_entries.size() - m_next; }
+        bool empty() const noexcept { return size() == 0; }
+        void clear() noexcept;
+
+        // Publishes the pending messages in order, then flushes if flushTimeout > 0.
+        // The batch is empty afterwards. If a publish fails, the exception is thrown
+        // and the messages not published yet stay in the batch for another submit().
+        void submit(int flushTimeout = 0);
+    };
+
+    // A fixed set of connections built from the same options, presenting the
+    // Client surface. Each call is routed to one connection, so publishers on
+    // different subjects (or threads) do not contend on one socket:
+    //     ClientPool pool(4);
+    //     pool.connect(opts);
+    //     pool.publish("orders.eu", payload);
+    // With ClientPool::Sharding::BySubject, messages on one subject always use the
+    // same connection and keep their order. Subscriptions receive messages from
+    // every connection of the pool, as from any other publisher. subscribe() and
+    // queueSubscribe() flush their connection before returning, so the subscription
+    // is registered on the server before messages go out on the other connections.
+    class ClientPool
+    {
+    public:
+        enum class Sharding : short
+        {
+            BySubject,  // hash of the subject
+            ByThread    // hash of the calling thread
+        };
+
+        explicit ClientPool(std::size_t size, Sharding sharding = Sharding::BySubject);
+        ~ClientPool() = default;
+        ClientPool(const ClientPool&) = delete;
+        ClientPool& operator=(const ClientPool&) = delete;
+
+        // Connects every connection; the pool is closed again if one of them fails.
+        void connect(const Options& opts);
+        void connect(const std::string& address);
+        void close() noexcept;
+
+        std::size_t size() const noexcept { return m_clients.size(); }
+        Client& at(std::size_t index) { return *m_clients.at(index); }
+        // The connection used for subject.
+        Client& client(std::string_view subject);
+        // Same connection as client(subject.str()), without hashing the subject again.
+        Client& client(const Subject& subject);
+
+        void publish(const Message& message);
+        void publish(std::string_view subject, std::string_view data);
+        void publish(std::string_view subject, std::span<const std::byte> data);
+        void publish(std::string_view subject, std::string_view data, std::string_view reply);
+        void publish(std::string_view subject, std::span<const std::byte> data, std::string_view reply);
+        void publish(const Subject& subject, std::string_view data);
+        void publish(const Subject& subject, std::span<const std::byte> data);
+        Status tryPublish(std::string_view subject, std::string_view data) noexcept;
+        Status tryPublish(const Subject& subject, std::string_view data) noexcept;
+        Subscription subscribe(const std::string& subject, const SubscribeOptions& options = SubscribeOptions());
+        Subscription subscribe(const std::string& subject, MessageHandler handler,
+                               const SubscribeOptions& options = SubscribeOptions());
+        Subscription subscribe(const Subject& subject, const SubscribeOptions& options = SubscribeOptions());
+        Subscription subscribe(const Subject& subject, MessageHandler handler,
+                               const SubscribeOptions& options = SubscribeOptions());
+        Subscription queueSubscribe(const std::string& subject, const std::string& group,
+                                    const SubscribeOptions& options = SubscribeOptions());
+        Subscription queueSubscribe(const std::string& subject, const std::string& group, MessageHandler handler,
+                                    const SubscribeOptions& options = SubscribeOptions());
+        Message request(const Message& message, int timeout);
         std::future<Message> requestAsync(const Message& message, int timeout);
+        std::future<Message> requestAsync(std::string_view subject, std::string_view data, int timeout);
+        RequestAwaiter requestAwait(const Message& message, int timeout);
+        RequestAwaiter requestAwait(std::string_view subject, std::string_view data, int timeout);
+
+        // Sum of the counters of all connections.
+        ClientStats stats() const;
+
+    private:
+        std::vector<std::unique_ptr<Client>> m_clients;
+        Sharding m_sharding;
+    };
+
+    // Handler of a Router route. Every matching route sees the same Message.
+    using RouteHandler = std::function<void(const Message&)>;
+
+    class RouteTable;
+
+    // Registration of a handler in a Router, removed when destroyed or by remove().
+    // A handler may still be running, or be invoked once more, while remove() returns.
+    class Route
+    {
+    public:
+        Route() = default;
+        ~Route() noexcept;
+        Route(const Route&) = delete;
+        Route& operator=(const Route&) = delete;
+        Route(Route&& other) noexcept;
+        Route& operator=(Route&& other) noexcept;
+
+        void remove() noexcept;
+
+    private:
+        std::weak_ptr<RouteTable> m_table;
+        uint64_t m_id = 0;
+        friend class Router;
+    };
+
+    // In-process fan-out: one server subscription per root subject, dispatched to
+    // local handlers through a token trie supporting '*' and '>':
+    //     Router router(client);
+    //     router.listen("orders.>");
+    //     Route eu = router.route("orders.eu.*", onEuOrder);
+    //     Route all = router.route("orders.>", onAnyOrder);
+    // A message costs one network delivery whatever the number of matching routes,
+    // and each of them is called with a reference to it, in no particular order.
+    // Routes can be added and removed at any time: the trie is copied on change and
+    // published by swapping its root, so dispatch never blocks on route changes. Only
+    // the pointer swap itself is shared with them (std::atomic<std::shared_ptr> is not
+    // lock-free, e.g. on libstdc++). Roots should not overlap, a message
+    // matching two of them is dispatched twice. Handlers run on the delivery thread
+    // of the root subscription (or on its workers, see SubscribeOptions::workers).
+    class Router
+    {
+    public:
+        explicit Router(Client& client);
+        ~Router() noexcept;
+        Router(const Router&) = delete;
+        Router& operator=(const Router&) = delete;
+
+        // Subscribes to subject on the server and dispatches its messages to the routes.
+        void listen(const std::string& subject, const SubscribeOptions& options = SubscribeOptions());
+        // pattern may contain wildcards. Throws Exception(NATS_INVALID_SUBJECT) if it
+        // is not a valid subject, or Exception(NATS_INVALID_ARG) on an empty handler.
+        Route route(std::string_view pattern, RouteHandler handler);
+        // Unsubscribes from every root, the routes stay registered.
+        void close() noexcept;
+        // Messages received that matched no route.
+        uint64_t unrouted() const noexcept;
+
+    private:
+        Client& m_client;
+        std::shared_ptr<RouteTable> m_table;
+        std::vector<Subscription> m_subscriptions;
+    };
+
+    // Failure of a JetStream call. errorCode is the cnats status, apiCode the error
+    // code returned by the JetStream API (0 when the server did not answer).
+    class JetStreamException : public Exception
+    {
+    public:
+        JetStreamException(natsStatus s, jsErrCode code = static_cast<jsErrCode>(0), std::string text = std::string())
+            : Exception(s), apiCode(code), m_text(std::move(text)) {}
+        jsErrCode apiCode;
+        const char* what() const noexcept override { return m_text.empty() ? Exception::what() : m_text.c_str(); }
+    private:
+        std::string m_text;
+    };
+
+    struct JetStreamOptions
+    {
+        // API prefix and domain, empty for the defaults
+        std::string prefix;
+        std::string domain;
+        // Time to wait for API replies and synchronous publish acks, in milliseconds.
+        int timeout = 5000;
+        // Most acks publishAsync() leaves outstanding. Beyond it, publishAsync() waits
+        // up to stallWait milliseconds for an ack, then fails with NATS_TIMEOUT.
+        int64_t maxPendingAcks = 4000;
+        int stallWait = 200;
+    };
+
+    enum class StorageType : short
+    {
+        File = js_FileStorage,
+        Memory = js_MemoryStorage
+    };
+
+    struct StreamConfig
+    {
+        std::string name;
+        std::vector<std::string> subjects;
+        StorageType storage = StorageType::File;
+        // -1 for unlimited
+        int64_t maxMsgs = -1;
+        int64_t maxBytes = -1;
+        int64_t maxMsgsPerSubject = -1;
+    };
+
+    struct StreamInfo
+    {
+        std::string name;
+        uint64_t msgs = 0;
+        uint64_t bytes = 0;
+        uint64_t firstSeq = 0;
+        uint64_t lastSeq = 0;
+    };
+
+    // Acknowledgement of a message stored by JetStream.
+    struct PubAck
+    {
+        std::string stream;
+        uint64_t sequence = 0;
+        // the message id was already stored
+        bool duplicate = false;
+    };
+
+    // Completion of publishAsync(): error is null when the message was stored.
+    // It runs on a cnats thread.
+    using PubAckHandler = std::function<void(const PubAck& ack, const JetStreamException* error)>;
+
+    enum class AckPolicy : short
+    {
+        Explicit = js_AckExplicit,  // every message is acknowledged on its own
+        All = js_AckAll,            // acknowledging a message acknowledges all the ones before it
+        None = js_AckNone
+    };
+
+    enum class DeliverPolicy : short
+    {
+        All = js_DeliverAll,
+        Last = js_DeliverLast,
+        New = js_DeliverNew
+    };
+
+    struct ConsumerConfig
+    {
+        // Empty for an ephemeral consumer, removed when unsubscribing.
+        std::string durable;
+        // Defaults to the subject given to pullSubscribe().
+        std::string filterSubject;
+        AckPolicy ackPolicy = AckPolicy::Explicit;
+        DeliverPolicy deliverPolicy = DeliverPolicy::All;
+        // Milliseconds before an unacknowledged message is redelivered, 0 for the server default.
+        int ackWait = 0;
+        // Most messages delivered but not acknowledged yet, 0 for the server default.
+        int64_t maxAckPending = 0;
+        // Keep the next batch coming while the current one is processed, see PullConsumer.
+        bool prefetch = false;
+    };
+
+    struct FetchOptions
+    {
+        // Most messages returned by one fetch.
+        int batch = 100;
+        // Most payload bytes returned by one fetch, 0 for no limit.
+        int64_t maxBytes = 0;
+        // Milliseconds the server waits to fill the batch before returning what it has.
+        int expires = 1000;
+    };
+
+    class JetStreamState;
+    class PullConsumer;
+    class KeyValue;
+    struct KeyValueConfig;
+    class ObjectStore;
+    struct ObjectStoreConfig;
+
+    // JetStream context, obtained from Client::jetStream(). Asynchronous publishes
+    // are pipelined: they return once the message is sent, and acks are matched
+    // back to their completion as they arrive:
+    //     auto js = client.jetStream();
+    //     for (auto& event : events) {
+    //         js.publishAsync("events.new", event, onAck);
+    //     }
+    //     js.waitForAcks(5000);
+    // Destroying the context waits up to JetStreamOptions::timeout for the pending
+    // acks; completions still pending then fail with NATS_TIMEOUT.
+    class JetStream
+    {
+    public:
+        JetStream() = default;
+        ~JetStream() = default;
+        JetStream(const JetStream&) = delete;
+        JetStream& operator=(const JetStream&) = delete;
+        JetStream(JetStream&&) noexcept = default;
+        JetStream& operator=(JetStream&&) noexcept = default;
+
+        void addStream(const StreamConfig& config);
+        void deleteStream(const std::string& name);
+        void purgeStream(const std::string& name);
+        StreamInfo streamInfo(const std::string& name);
+
+        // Publishes and waits for the ack.
+        PubAck publish(std::string_view subject, std::string_view data);
+        PubAck publish(const Message& message);
+
+        // Publishes without waiting for the ack. The message, or its copy, is owned
+        // by cnats until the ack arrives.
+        void publishAsync(std::string_view subject, std::string_view data, PubAckHandler handler);
+        void publishAsync(Message&& message, PubAckHandler handler);
+        // The future fails with a JetStreamException.
+        std::future<PubAck> publishAsync(std::string_view subject, std::string_view data);
+
+        // Creates (or binds to, for a durable name that already exists) a pull consumer on subject.
+        PullConsumer pullSubscribe(const std::string& subject, const ConsumerConfig& config = ConsumerConfig());
+
+        // Key-value buckets, see KeyValue.
+        KeyValue createKeyValue(const KeyValueConfig& config);
+        KeyValue keyValue(const std::string& bucket);
+        void deleteKeyValue(const std::string& bucket);
+
+        // Object store buckets, see ObjectStore.
+        ObjectStore createObjectStore(const ObjectStoreConfig& config);
+        ObjectStore objectStore(const std::string& bucket);
+        void deleteObjectStore(const std::string& bucket);
+
+        // Waits until every publishAsync() so far has completed. Throws
+        // Exception(NATS_TIMEOUT) if some are still pending after timeout milliseconds.
+        void waitForAcks(int timeout);
+        std::size_t pendingAcks() const;
+
+    private:
+        std::shared_ptr<JetStreamState> m_state;
+        friend class Client;
+        friend class ObjectStore;
+    };
+
+    class PullConsumerState;
+
+    // Pull consumer created by JetStream::pullSubscribe(). Messages come in batches,
+    // one request per batch instead of one per message:
+    //     std::vector<Message> batch;
+    //     while (consumer.fetch(batch, options) > 0) {
+    //         process(batch);
+    //         consumer.ack(batch);
+    //     }
+    // With ConsumerConfig::prefetch, a background thread requests the next batch
+    // as soon as fetch() hands one out, so the next fetch() usually returns at once.
+    // Prefetched messages count against the ack wait while they sit in memory.
+    class PullConsumer
+    {
+    public:
+        PullConsumer() = default;
+        ~PullConsumer();
+        PullConsumer(const PullConsumer&) = delete;
+        PullConsumer& operator=(const PullConsumer&) = delete;
+        PullConsumer(PullConsumer&& other) noexcept = default;
+        PullConsumer& operator=(PullConsumer&& other) noexcept;
+
+        // Replaces the content of out with the next batch and returns its size, 0
+        // if nothing arrived within options.expires. Reusing out across calls keeps its storage.
+        std::size_t fetch(std::vector<Message>& out, const FetchOptions& options = FetchOptions());
+        std::vector<Message> fetch(const FetchOptions& options = FetchOptions());
+
+        // Acknowledgements are published without waiting for the server.
+        void ack(const Message& message);
+        // Acknowledges a whole batch: with AckPolicy::All only its last message is
+        // sent, since it covers the ones before it.
+        void ack(std::span<const Message> batch);
+        // Asks for redelivery.
+        void nak(const Message& message);
+        // Resets the ack wait of a message still being processed.
+        void inProgress(const Message& message);
+        // Stops redelivery of a message that cannot be processed.
+        void term(const Message& message);
+
+        // Stops prefetching and removes the subscription (and an ephemeral consumer).
+        void unsubscribe() noexcept;
+
+    private:
+        std::shared_ptr<PullConsumerState> m_state;
+        friend class JetStream;
+    };
+
+    struct KeyValueConfig
+    {
+        std::string bucket;
+        // Values kept per key, 1 to 64.
+        uint8_t history = 1;
+        // Milliseconds a value is kept, 0 for ever.
+        int64_t ttl = 0;
+        // -1 for unlimited
+        int64_t maxBytes = -1;
+        int32_t maxValueSize = -1;
+        StorageType storage = StorageType::File;
+    };
+
+    enum class KeyValueOp : short
+    {
+        Put = kvOp_Put,
+        Delete = kvOp_Delete,
+        Purge = kvOp_Purge
+    };
+
+    struct KeyValueEntry
+    {
+        std::string key;
+        std::string value;
+        uint64_t revision = 0;
+        KeyValueOp operation = KeyValueOp::Put;
+    };
+
+    // Hash accepting std::string_view, so snapshots can be searched without building a std::string.
+    struct KeyHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const noexcept { return std::hash<std::string_view>()(key); }
+    };
+
+    // Content of a bucket at one point in time, see KeyValue::enableCache().
+    using KeyValueSnapshot = std::unordered_map<std::string, KeyValueEntry, KeyHash, std::equal_to<>>;
+
+    class KeyValueWatcherState;
+
+    // Updates of the keys of a bucket, obtained from KeyValue::watch(). The current
+    // values come first, followed by one empty entry (revision 0), then live updates.
+    class KeyValueWatcher
+    {
+    public:
+        KeyValueWatcher() = default;
+        ~KeyValueWatcher();
+        KeyValueWatcher(const KeyValueWatcher&) = delete;
+        KeyValueWatcher& operator=(const KeyValueWatcher&) = delete;
+        KeyValueWatcher(KeyValueWatcher&&) noexcept = default;
+        KeyValueWatcher& operator=(KeyValueWatcher&& other) noexcept;
+
+        // Waits up to timeout milliseconds for the next update, throws Exception(NATS_TIMEOUT).
+        KeyValueEntry next(int timeout = 1000);
+        void stop() noexcept;
+
+    private:
+        std::shared_ptr<KeyValueWatcherState> m_state;
+        friend class KeyValue;
+    };
+
+    class KeyValueState;
+
+    // A key-value bucket, obtained from JetStream::createKeyValue() or keyValue().
+    // With enableCache(), a background watch keeps a copy of the whole bucket in
+    // memory. get() then reads the latest snapshot without a server round trip, and
+    // never waits for the cache to be updated. The cache lags behind writes by one
+    // delivery, including this client's own writes. Each update rebuilds the snapshot,
+    // a copy of the whole bucket: the cache suits buckets read far more often than
+    // written, it costs O(keys) per write.
+    class KeyValue
+    {
+    public:
+        KeyValue() = default;
+        ~KeyValue() = default;
+        KeyValue(const KeyValue&) = delete;
+        KeyValue& operator=(const KeyValue&) = delete;
+        KeyValue(KeyValue&&) noexcept = default;
+        KeyValue& operator=(KeyValue&&) noexcept = default;
+
+        // Empty when the key does not exist or was deleted.
+        std::optional<KeyValueEntry> get(std::string_view key) const;
+        // Each write returns the revision of the new value.
+        uint64_t put(std::string_view key, std::string_view value);
+        // Fails with JetStreamException if the key exists.
+        uint64_t create(std::string_view key, std::string_view value);
+        // Fails with JetStreamException unless lastRevision is the current revision of the key.
+        uint64_t update(std::string_view key, std::string_view value, uint64_t lastRevision);
+        // Leaves a delete marker, purge() also removes the history.
+        void remove(std::string_view key);
+        void purge(std::string_view key);
+
+        // keys may contain wildcards, ">" watches the whole bucket.
+        KeyValueWatcher watch(std::string_view keys = ">");
+
+        // Starts the watch feeding get(). Until the current values are loaded, get()
+        // still asks the server, and so it does again if the watch fails: the cache is
+        // then dropped rather than serving stale values.
+        // Throws Exception(NATS_INVALID_ARG) if the bucket has a ttl: the server expires
+        // entries without telling watchers, the cache would go on serving them.
+        void enableCache();
+        // Latest snapshot of the cache, null while it is not loaded or after the watch failed.
+        std::shared_ptr<const KeyValueSnapshot> snapshot() const;
+
+    private:
+        std::shared_ptr<KeyValueState> m_state;
+        friend class JetStream;
+    };
+
+    struct ObjectStoreConfig
+    {
+        std::string bucket;
+        StorageType storage = StorageType::File;
+        // -1 for unlimited
+        int64_t maxBytes = -1;
+        // Size of the messages objects are split into.
+        std::size_t chunkSize = 128 * 1024;
+        // Chunks in flight during put() and get(), which bounds their memory use
+        // to about window * chunkSize.
+        int window = 32;
+    };
+
+    struct ObjectInfo
+    {
+        std::string name;
+        // id of the chunks of this version of the object
+        std::string nuid;
+        uint64_t size = 0;
+        uint64_t chunks = 0;
+        // "SHA-256=<base64url>" of the content, empty if the writer did not set one
+        std::string digest;
+    };
+
+    // Source of an object: fills buffer and returns the number of bytes written
+    // to it, 0 at the end of the object.
+    using ObjectReader = std::function<std::size_t(std::span<std::byte> buffer)>;
+    // Receives the chunks of an object in order.
+    using ObjectWriter = std::function<void(std::span<const std::byte> chunk)>;
+
+    // Bucket of large objects, obtained from JetStream::createObjectStore() or
+    // objectStore(). Objects are streamed in chunks, so neither put() nor get()
+    // holds a whole object in memory: a memory-mapped file can be passed as a span,
+    // or a file descriptor read and written directly.
+    // The layout (stream OBJ_<bucket>, subjects $O.<bucket>.C.<nuid> for chunks and
+    // $O.<bucket>.M.<name> for metadata) and the SHA-256 digest are the ones of the
+    // other NATS clients. get() checks the digest once the whole object has been
+    // handed to the writer, and throws Exception(NATS_ERR) if it does not match.
+    class ObjectStore
+    {
+    public:
+        ObjectStore() = default;
+        ObjectStore(ObjectStore&&) noexcept = default;
+        ObjectStore& operator=(ObjectStore&&) noexcept = default;
+
+        // Stores a new version of name, then removes the chunks of the previous one.
+        ObjectInfo put(const std::string& name, const ObjectReader& reader);
+        ObjectInfo put(const std::string& name, std::span<const std::byte> data);
+        ObjectInfo put(const std::string& name, std::string_view data);
+        ObjectInfo putFile(const std::string& name, int fd);
+
+        // Throws Exception(NATS_NOT_FOUND) if name does not exist.
+        ObjectInfo get(const std::string& name, const ObjectWriter& writer);
+        std::string get(const std::string& name);
+        ObjectInfo getFile(const std::string& name, int fd);
+
+        // Empty when name does not exist.
+        std::optional<ObjectInfo> info(const std::string& name);
+        void remove(const std::string& name);
+
+    private:
+        JetStream m_js;
+        std::string m_bucket;
+        std::size_t m_chunkSize = 128 * 1024;
+        int m_window = 32;
 
+        std::string metaSubject(const std::string& name) const;
+        void purgeChunks(const std::string& nuid);
+        friend class JetStream;
     };
     
     
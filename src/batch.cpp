@@ -0,0 +1,95 @@
+/**
+ * @file batch.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <cstring>
+#include "cppnats.hpp"
+#include "flow.hpp"
+
+
+namespace CppNats {
+
+    PublishBatch Client::batch()
+    {
+        return PublishBatch(*this);
+    }
+
+    std::size_t PublishBatch::append(const void* data, std::size_t length, bool terminate)
+    {
+        auto offset = m_arena.size();
+        m_arena.resize(offset + length + (terminate ? 1 : 0));
+        if (length > 0) {
+            std::memcpy(m_arena.data() + offset, data, length);
+        }
+        if (terminate) {
+            m_arena[offset + length] = '\0';
+        }
+        return offset;
+    }
+
+    PublishBatch& PublishBatch::add(std::string_view subject, std::string_view data, std::string_view reply)
+    {
+        return add(subject, std::as_bytes(std::span<const char>(data.data(), data.size())), reply);
+    }
+
+    PublishBatch& PublishBatch::add(std::string_view subject, std::span<const std::byte> data, std::string_view reply)
+    {
+        if (subject.empty()) {
+            throw Exception(NATS_INVALID_SUBJECT);
+        }
+        Entry entry;
+        entry.subject = append(subject.data(), subject.size(), true);
+        entry.hasReply = !reply.empty();
+        entry.reply = entry.hasReply ? append(reply.data(), reply.size(), true) : 0;
+        entry.data = append(data.data(), data.size(), false);
+        entry.dataLength = data.size();
+        m_entries.push_back(entry);
+        return *this;
+    }
+
+    void PublishBatch::clear() noexcept
+    {
+        m_arena.clear();
+        m_entries.clear();
+        m_next = 0;
+    }
+
+    void PublishBatch::submit(int flushTimeout)
+    {
+        natsConnection* conn = m_client.m_conn;
+        const char* arena = m_arena.data();
+        for (; m_next < m_entries.size(); ++m_next) {
+            const Entry& entry = m_entries[m_next];
+            natsStatus err;
+            if (entry.hasReply) {
+                err = natsConnection_PublishRequest(conn, arena + entry.subject, arena + entry.reply,
+                                                    arena + entry.data, static_cast<int>(entry.dataLength));
+            } else {
+                err = natsConnection_Publish(conn, arena + entry.subject,
+                                             arena + entry.data, static_cast<int>(entry.dataLength));
+            }
+            if (err != NATS_OK) {
+                throw Exception(err);
+            }
+        }
+        clear();
+        if (m_client.m_flow) {
+            m_client.m_flow->check();
+        }
+        if (flushTimeout > 0) {
+            auto err = natsConnection_FlushTimeout(conn, flushTimeout);
+            if (err != NATS_OK) {
+                throw Exception(err);
+            }
+        }
+    }
+
+} // namespace CppNats
@@ -0,0 +1,267 @@
+/**
+ * @file consumer.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "cppnats.hpp"
+#include "jetstream.hpp"
+
+
+namespace CppNats {
+
+    // The cnats pull subscription and, with prefetch, the thread fetching ahead.
+    class PullConsumerState
+    {
+        public:
+            PullConsumerState(std::shared_ptr<JetStreamState> js, AckPolicy ackPolicy, bool prefetch)
+                : js(std::move(js)), ackPolicy(ackPolicy), prefetch(prefetch) {}
+
+            ~PullConsumerState()
+            {
+                close();
+                natsMsgList_Destroy(&staged);
+                natsSubscription_Destroy(sub);
+            }
+
+            // One fetch request. NATS_TIMEOUT means nothing arrived.
+            natsStatus fetchNow(natsMsgList& list, const FetchOptions& options)
+            {
+                jsFetchRequest req;
+                jsFetchRequest_Init(&req);
+                req.Batch = options.batch;
+                req.MaxBytes = options.maxBytes;
+                // nanoseconds
+                req.Expires = static_cast<int64_t>(options.expires) * 1000000;
+                return natsSubscription_FetchRequest(&list, sub, &req);
+            }
+
+            // Hands out the prefetched batch, waiting for it if needed, and requests the next one.
+            natsStatus takePrefetched(natsMsgList& list, const FetchOptions& options)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!thread.joinable()) {
+                    thread = std::thread(&PullConsumerState::run, this);
+                }
+                if (!ready && !requested) {
+                    next = options;
+                    requested = true;
+                    cond.notify_all();
+                }
+                cond.wait(lock, [this] { return ready || stop; });
+                if (!ready) {
+                    return NATS_INVALID_SUBSCRIPTION;
+                }
+                list = staged;
+                staged = natsMsgList();
+                ready = false;
+                auto status = stagedStatus;
+                next = options;
+                requested = true;
+                cond.notify_all();
+                return status;
+            }
+
+            void close() noexcept
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stop = true;
+                    cond.notify_all();
+                }
+                // at most one fetch request (FetchOptions::expires) away
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+
+            natsSubscription* sub = nullptr;
+            // keeps the jsCtx alive
+            std::shared_ptr<JetStreamState> js;
+            const AckPolicy ackPolicy;
+            const bool prefetch;
+
+        private:
+            void run()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true) {
+                    cond.wait(lock, [this] { return requested || stop; });
+                    if (stop) {
+                        return;
+                    }
+                    requested = false;
+                    FetchOptions options = next;
+                    lock.unlock();
+                    natsMsgList list = natsMsgList();
+                    auto status = fetchNow(list, options);
+                    lock.lock();
+                    staged = list;
+                    stagedStatus = status;
+                    ready = true;
+                    cond.notify_all();
+                    // the next request comes from takePrefetched()
+                }
+            }
+
+            std::mutex mutex;
+            std::condition_variable cond;
+            std::thread thread;
+            FetchOptions next;
+            bool requested = false;
+            bool ready = false;
+            bool stop = false;
+            natsMsgList staged = natsMsgList();
+            natsStatus stagedStatus = NATS_OK;
+    };
+
+    PullConsumer JetStream::pullSubscribe(const std::string& subject, const ConsumerConfig& config)
+    {
+        if (!m_state) {
+            throw Exception(NATS_ILLEGAL_STATE);
+        }
+        jsConsumerConfig cc;
+        jsConsumerConfig_Init(&cc);
+        cc.Durable = config.durable.empty() ? nullptr : config.durable.c_str();
+        cc.FilterSubject = config.filterSubject.empty() ? nullptr : config.filterSubject.c_str();
+        cc.AckPolicy = static_cast<jsAckPolicy>(config.ackPolicy);
+        cc.DeliverPolicy = static_cast<jsDeliverPolicy>(config.deliverPolicy);
+        // nanoseconds
+        cc.AckWait = static_cast<int64_t>(config.ackWait) * 1000000;
+        cc.MaxAckPending = config.maxAckPending;
+        jsSubOptions so;
+        jsSubOptions_Init(&so);
+        so.Config = &cc;
+
+        auto state = std::make_shared<PullConsumerState>(m_state, config.ackPolicy, config.prefetch);
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_PullSubscribe(&state->sub, m_state->js, subject.c_str(), cc.Durable, nullptr, &so, &code);
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+        PullConsumer consumer;
+        consumer.m_state = std::move(state);
+        return consumer;
+    }
+
+    PullConsumer::~PullConsumer()
+    {
+        unsubscribe();
+    }
+
+    PullConsumer& PullConsumer::operator=(PullConsumer&& other) noexcept
+    {
+        if (this != &other) {
+            unsubscribe();
+            m_state = std::move(other.m_state);
+        }
+        return *this;
+    }
+
+    static PullConsumerState& stateOf(const std::shared_ptr<PullConsumerState>& state)
+    {
+        if (!state) {
+            throw Exception(NATS_INVALID_SUBSCRIPTION);
+        }
+        return *state;
+    }
+
+    std::size_t PullConsumer::fetch(std::vector<Message>& out, const FetchOptions& options)
+    {
+        auto& state = stateOf(m_state);
+        if (options.batch <= 0 || options.expires <= 0) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        out.clear();
+        natsMsgList list = natsMsgList();
+        auto err = state.prefetch ? state.takePrefetched(list, options) : state.fetchNow(list, options);
+        if (err != NATS_OK && err != NATS_TIMEOUT) {
+            natsMsgList_Destroy(&list);
+            throwJetStream(err);
+        }
+        out.reserve(list.Count);
+        for (int i = 0; i < list.Count; ++i) {
+            out.emplace_back(list.Msgs[i]);
+            // now owned by out
+            list.Msgs[i] = nullptr;
+        }
+        natsMsgList_Destroy(&list);
+        return out.size();
+    }
+
+    std::vector<Message> PullConsumer::fetch(const FetchOptions& options)
+    {
+        std::vector<Message> out;
+        fetch(out, options);
+        return out;
+    }
+
+    static void acknowledge(natsStatus (*send)(natsMsg*, jsOptions*), const Message& message)
+    {
+        if (message.empty()) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        auto err = send(message.getNatsMsg(), nullptr);
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+    }
+
+    void PullConsumer::ack(const Message& message)
+    {
+        stateOf(m_state);
+        acknowledge(natsMsg_Ack, message);
+    }
+
+    void PullConsumer::ack(std::span<const Message> batch)
+    {
+        auto& state = stateOf(m_state);
+        if (batch.empty() || state.ackPolicy == AckPolicy::None) {
+            return;
+        }
+        if (state.ackPolicy == AckPolicy::All) {
+            acknowledge(natsMsg_Ack, batch.back());
+            return;
+        }
+        for (auto& message : batch) {
+            acknowledge(natsMsg_Ack, message);
+        }
+    }
+
+    void PullConsumer::nak(const Message& message)
+    {
+        stateOf(m_state);
+        acknowledge(natsMsg_Nak, message);
+    }
+
+    void PullConsumer::inProgress(const Message& message)
+    {
+        stateOf(m_state);
+        acknowledge(natsMsg_InProgress, message);
+    }
+
+    void PullConsumer::term(const Message& message)
+    {
+        stateOf(m_state);
+        acknowledge(natsMsg_Term, message);
+    }
+
+    void PullConsumer::unsubscribe() noexcept
+    {
+        if (m_state) {
+            m_state->close();
+            natsSubscription_Unsubscribe(m_state->sub);
+            m_state.reset();
+        }
+    }
+
+} // namespace CppNats
@@ -18,6 +18,11 @@
 #include <vector>
 #include "cppnats.hpp"
 #include "helper.hpp"
+#include "flow.hpp"
+#include "subscription.hpp"
+#include "request.hpp"
+#include "timer.hpp"
+#include "events.hpp"
 
 
 namespace CppNats {
@@ -132,6 +137,7 @@ namespace CppNats {
         if (err != NATS_OK) {
             throw Exception(err);
         }
+        reconnectBufSize = size;
     }
 
     void Options::setReconnectJitter(int jitter, int jitterTLS)
@@ -142,6 +148,46 @@ namespace CppNats {
         }
     }
 
+    void Options::setPayloadPool(std::size_t largestBlock, std::size_t blocksPerChunk)
+    {
+        if (largestBlock == 0) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        payloadPool = true;
+        payloadPoolOptions.largest_required_pool_block = largestBlock;
+        payloadPoolOptions.max_blocks_per_chunk = blocksPerChunk;
+    }
+
+    void Options::setDisconnectedHandler(ConnectionHandler handler)
+    {
+        disconnectedHandler = std::move(handler);
+    }
+
+    void Options::setReconnectedHandler(ConnectionHandler handler)
+    {
+        reconnectedHandler = std::move(handler);
+    }
+
+    void Options::setClosedHandler(ConnectionHandler handler)
+    {
+        closedHandler = std::move(handler);
+    }
+
+    void Options::setErrorHandler(ConnectionErrorHandler handler)
+    {
+        errorHandler = std::move(handler);
+    }
+
+    void Options::setWriteWatermarks(std::size_t high, std::size_t low, WatermarkHandler handler)
+    {
+        if (low == 0 || low >= high || !handler) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        highWatermark = high;
+        lowWatermark = low;
+        watermarkHandler = std::move(handler);
+    }
+
     void Options::setNKeyFromSeed(const std::string& nkey, const std::string& userCreds)
     {
         auto err = natsOptions_SetNKeyFromSeed(this->natsOpts, nkey.c_str(), userCreds.c_str());
@@ -194,107 +240,456 @@ namespace CppNats {
         }
     }
 
+    Message::Message(const Subject& subject, std::string_view data) : m_msg(nullptr)
+    {
+        // messages are published, a wildcard is only valid to subscribe
+        if (subject.wildcard()) {
+            throw Exception(NATS_INVALID_SUBJECT);
+        }
+        auto err = natsMsg_Create(&m_msg, subject.c_str(), nullptr, data.data(), static_cast<int>(data.size()));
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+    }
+
     Message::~Message() noexcept
     {
         natsMsg_Destroy(m_msg);
     }   
+
+    Message& Message::operator=(Message&& other) noexcept
+    {
+        if (this != &other) {
+            setMsg(other.release());
+        }
+        return *this;
+    }
+
+    void Message::setMsg(natsMsg* msg) noexcept
+    {
+        natsMsg_Destroy(m_msg);
+        m_msg = msg;
+    }
+
+    natsMsg* Message::release() noexcept
+    {
+        natsMsg* msg = m_msg;
+        m_msg = nullptr;
+        return msg;
+    }
+
+    // natsMsg is immutable once created, so every change builds a new one
+    static natsMsg* createMsg(std::string_view subject, std::string_view data, std::string_view reply)
+    {
+        natsMsg* msg = nullptr;
+        std::string subj(subject);
+        std::string rep(reply);
+        auto err = natsMsg_Create(&msg, subj.c_str(), rep.c_str(), data.data(), static_cast<int>(data.size()));
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+        return msg;
+    }
+
+    // Same as createMsg(), with the headers of from.
+    static natsMsg* rebuildMsg(const Message& from, std::string_view subject, std::string_view data,
+                               std::string_view reply)
+    {
+        Message msg(createMsg(subject, data, reply));
+        from.forEachHeader([&msg](std::string_view key, std::string_view value) {
+            msg.addHeader(key, value);
+        });
+        return msg.release();
+    }
+
+    Message Message::clone() const
+    {
+        if (!m_msg) {
+            return Message();
+        }
+        return Message(rebuildMsg(*this, subject(), data(), reply()));
+    }
+
+    void Message::setSubject(const std::string& subject)
+    {
+        setMsg(rebuildMsg(*this, subject, data(), reply()));
+    }
+
+    void Message::setData(const std::string& data)
+    {
+        setMsg(rebuildMsg(*this, subject(), data, reply()));
+    }
+
+    void Message::setReply(const std::string& reply)
+    {
+        setMsg(rebuildMsg(*this, subject(), data(), reply));
+    }
+
+    std::string_view Message::header(std::string_view key) const
+    {
+        const char* value = nullptr;
+        if (!m_msg) {
+            return std::string_view();
+        }
+        CString k(key);
+        if (natsMsgHeader_Get(m_msg, k.c_str(), &value) != NATS_OK || !value) {
+            return std::string_view();
+        }
+        return std::string_view(value);
+    }
+
+    bool Message::hasHeader(std::string_view key) const
+    {
+        const char* value = nullptr;
+        if (!m_msg) {
+            return false;
+        }
+        CString k(key);
+        return natsMsgHeader_Get(m_msg, k.c_str(), &value) == NATS_OK;
+    }
+
+    void Message::setHeader(std::string_view key, std::string_view value)
+    {
+        // keys and values are usually short enough to stay on the stack
+        CString k(key);
+        CString v(value);
+        auto err = natsMsgHeader_Set(m_msg, k.c_str(), v.c_str());
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+    }
+
+    void Message::addHeader(std::string_view key, std::string_view value)
+    {
+        CString k(key);
+        CString v(value);
+        auto err = natsMsgHeader_Add(m_msg, k.c_str(), v.c_str());
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+    }
+
+    void Message::removeHeader(std::string_view key)
+    {
+        CString k(key);
+        auto err = natsMsgHeader_Delete(m_msg, k.c_str());
+        if (err != NATS_OK && err != NATS_NOT_FOUND) {
+            throw Exception(err);
+        }
+    }
     
-    const std::string Message::subject() const
+    // cnats returns NULL for missing fields (and for every field of a NULL message)
+    static std::string_view viewOf(const char* str) noexcept
     {
-        return std::string(natsMsg_GetSubject(m_msg));
+        return str ? std::string_view(str) : std::string_view();
     }
 
-    const std::string Message::data() const
+    std::string_view Message::subject() const noexcept
     {
-        return std::string(natsMsg_GetData(m_msg), natsMsg_GetDataLength(m_msg));
+        return viewOf(natsMsg_GetSubject(m_msg));
     }
 
-    const std::string Message::reply() const
-    {        
-        return std::string(natsMsg_GetReply(m_msg));
-    }   
+    std::string_view Message::data() const noexcept
+    {
+        const char* data = natsMsg_GetData(m_msg);
+        if (!data) {
+            return std::string_view();
+        }
+        return std::string_view(data, natsMsg_GetDataLength(m_msg));
+    }
+
+    std::string_view Message::reply() const noexcept
+    {
+        return viewOf(natsMsg_GetReply(m_msg));
+    }
+
+    std::span<const std::byte> Message::bytes() const noexcept
+    {
+        auto payload = data();
+        return std::as_bytes(std::span<const char>(payload.data(), payload.size()));
+    }
+
+    std::string Message::subjectCopy() const
+    {
+        return std::string(subject());
+    }
+
+    std::string Message::dataCopy() const
+    {
+        return std::string(data());
+    }
+
+    std::string Message::replyCopy() const
+    {
+        return std::string(reply());
+    }
+
+    std::pmr::string Message::subjectCopy(std::pmr::memory_resource* resource) const
+    {
+        return std::pmr::string(subject(), resource);
+    }
+
+    std::pmr::string Message::dataCopy(std::pmr::memory_resource* resource) const
+    {
+        return std::pmr::string(data(), resource);
+    }
 
-    bool Message::operator==(const Message &other) const
+    std::pmr::string Message::replyCopy(std::pmr::memory_resource* resource) const
     {
-        return subject() == other.subject()
-            && data() == other.data()
+        return std::pmr::string(reply(), resource);
+    }
+
+    bool Message::operator==(const Message &other) const noexcept
+    {
+        return data() == other.data()
+            && subject() == other.subject()
             && reply() == other.reply();
     }
 
 
-    Client::Client() : m_conn(nullptr) {}
+    Client::Client() : m_conn(nullptr), m_timer(std::make_shared<TimerService>()) {}
 
     Client::~Client() noexcept
     {
+        if (m_mux) {
+            m_mux->close();
+        }
+        m_mux.reset();
+        if (m_flow) {
+            m_flow->detach();
+        }
         if (m_conn) {
             natsConnection_Destroy(m_conn);
         }
     }
 
-    void Client::connect(const Options& opts)
+    void Client::connect(natsOptions* opts, std::shared_ptr<ConnectionEvents> events)
     {
-        auto err = natsConnection_Connect(&m_conn, opts.natsOpts);
+        auto closure = ConnectionEvents::install(opts, events);
+        auto err = natsConnection_Connect(&m_conn, opts);
         if (err != NATS_OK) {
+            ConnectionEvents::release(closure);
             throw Exception(err);
         }
+        m_events = std::move(events);
+    }
+
+    void Client::connect(const Options& opts)
+    {
+        auto events = std::make_shared<ConnectionEvents>();
+        events->disconnectedHandler = opts.disconnectedHandler;
+        events->reconnectedHandler = opts.reconnectedHandler;
+        events->closedHandler = opts.closedHandler;
+        events->errorHandler = opts.errorHandler;
+        connect(opts.natsOpts, std::move(events));
+        m_payloadPool = opts.payloadPool;
+        m_payloadPoolOptions = opts.payloadPoolOptions;
+        m_reconnectBufSize = opts.reconnectBufSize;
+        if (opts.watermarkHandler) {
+            m_flow = std::make_shared<FlowControl>(m_conn, opts.highWatermark, opts.lowWatermark,
+                                                   opts.watermarkHandler, m_timer);
+        }
     }
 
     void Client::connect(const std::string& address)
     {
-        auto err = natsConnection_ConnectTo(&m_conn, address.c_str());
+        // same as natsConnection_ConnectTo, with our callbacks installed
+        natsOptions* opts = nullptr;
+        auto err = natsOptions_Create(&opts);
+        if (err == NATS_OK) {
+            err = natsOptions_SetURL(opts, address.c_str());
+        }
         if (err != NATS_OK) {
+            natsOptions_Destroy(opts);
             throw Exception(err);
         }
+        try {
+            connect(opts, std::make_shared<ConnectionEvents>());
+        } catch (...) {
+            natsOptions_Destroy(opts);
+            throw;
+        }
+        natsOptions_Destroy(opts);
     }
 
     void Client::close() noexcept
     {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_mux) {
+                m_mux->close();
+                m_mux.reset();
+            }
+        }
+        if (m_flow) {
+            m_flow->detach();
+        }
         if (m_conn) {
             natsConnection_Close(m_conn);
         }
     }
 
+    natsStatus Client::send(const char* subject, std::span<const std::byte> data, const char* reply) noexcept
+    {
+        auto size = static_cast<int>(data.size());
+        auto err = reply ? natsConnection_PublishRequest(m_conn, subject, reply, data.data(), size)
+                         : natsConnection_Publish(m_conn, subject, data.data(), size);
+        if (err == NATS_OK && m_flow) {
+            m_flow->check();
+        }
+        return err;
+    }
+
     void Client::publish(const Message& message)
     {
-        auto err = natsConnection_PublishMsg(m_conn, message.getNatsMsg());
-        if (err != NATS_OK) {
-            throw Exception(err);
+        auto status = tryPublish(message);
+        if (status != Status::Ok) {
+            throw Exception(static_cast<natsStatus>(status));
         }
     }
 
-    Subscription Client::subscribe(const std::string& subject, const int timeout)
+    void Client::publish(std::string_view subject, std::string_view data)
     {
-        Subscription sub;
-        auto callback = [](natsConnection* nc, natsSubscription* sub, natsMsg* msg, void* closure) {
-            CppNats::QMessages* q = static_cast<CppNats::QMessages*>(closure);
-            if (msg) {
-                Message reply;
-                reply.setMsg(msg);
-                q->push(reply);
-            } else {
-                //p->set_exception(std::make_exception_ptr(Exception(NATS_TIMEOUT)));
-            }
-            // todo create a thread ? to push in queue
+        publish(subject, data, std::string_view());
+    }
+
+    void Client::publish(std::string_view subject, std::span<const std::byte> data)
+    {
+        publish(subject, data, std::string_view());
+    }
 
-        };
+    void Client::publish(std::string_view subject, std::string_view data, std::string_view reply)
+    {
+        publish(subject, std::as_bytes(std::span<const char>(data.data(), data.size())), reply);
+    }
 
-        auto err = natsConnection_SubscribeTimeout(&sub.m_sub, m_conn, subject.data(), timeout, callback, &sub.m_queue);
+    void Client::publish(std::string_view subject, std::span<const std::byte> data, std::string_view reply)
+    {
+        CString subj(subject);
+        natsStatus err;
+        if (reply.empty()) {
+            err = send(subj.c_str(), data, nullptr);
+        } else {
+            CString rep(reply);
+            err = send(subj.c_str(), data, rep.c_str());
+        }
         if (err != NATS_OK) {
             throw Exception(err);
         }
+    }
+
+    void Client::publish(const Subject& subject, std::string_view data)
+    {
+        publish(subject, std::as_bytes(std::span<const char>(data.data(), data.size())));
+    }
+
+    void Client::publish(const Subject& subject, std::span<const std::byte> data)
+    {
+        auto status = tryPublish(subject, data);
+        if (status != Status::Ok) {
+            throw Exception(static_cast<natsStatus>(status));
+        }
+    }
+
+    Status Client::tryPublish(const Message& message) noexcept
+    {
+        auto err = natsConnection_PublishMsg(m_conn, message.getNatsMsg());
+        if (err == NATS_OK && m_flow) {
+            m_flow->check();
+        }
+        return static_cast<Status>(err);
+    }
+
+    Status Client::tryPublish(std::string_view subject, std::string_view data) noexcept
+    {
+        return tryPublish(subject, std::as_bytes(std::span<const char>(data.data(), data.size())));
+    }
+
+    Status Client::tryPublish(std::string_view subject, std::span<const std::byte> data) noexcept
+    {
+        try {
+            CString subj(subject);
+            return static_cast<Status>(send(subj.c_str(), data, nullptr));
+        } catch (...) {
+            // only a long subject allocates
+            return Status::NoMemory;
+        }
+    }
+
+    Status Client::tryPublish(const Subject& subject, std::string_view data) noexcept
+    {
+        return tryPublish(subject, std::as_bytes(std::span<const char>(data.data(), data.size())));
+    }
+
+    Status Client::tryPublish(const Subject& subject, std::span<const std::byte> data) noexcept
+    {
+        if (subject.wildcard()) {
+            return Status::InvalidSubject;
+        }
+        return static_cast<Status>(send(subject.c_str(), data, nullptr));
+    }
+
+    bool Client::congested() const noexcept
+    {
+        return m_flow && m_flow->above();
+    }
+
+    SubscriptionContext Client::subscriptionContext() const
+    {
+        SubscriptionContext context;
+        context.timer = m_timer;
+        context.payloadPool = m_payloadPool ? &m_payloadPoolOptions : nullptr;
+        context.events = m_events;
+        return context;
+    }
+
+    Subscription Client::subscribe(const std::string& subject, const SubscribeOptions& options)
+    {
+        return queueSubscribe(subject, std::string(), options);
+    }
+
+    Subscription Client::subscribe(const std::string& subject, MessageHandler handler, const SubscribeOptions& options)
+    {
+        return queueSubscribe(subject, std::string(), std::move(handler), options);
+    }
+
+    // The interned subject is handed to cnats as is.
+    Subscription Client::subscribe(const Subject& subject, const SubscribeOptions& options)
+    {
+        Subscription sub;
+        sub.m_state = SubscriptionState::create(m_conn, subject.c_str(), std::string(), options, subscriptionContext());
+        return sub;
+    }
+
+    Subscription Client::subscribe(const Subject& subject, MessageHandler handler, const SubscribeOptions& options)
+    {
+        if (!handler) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        Subscription sub;
+        sub.m_state = SubscriptionState::create(m_conn, subject.c_str(), std::string(), options, subscriptionContext(),
+                                                std::move(handler));
         return sub;
     }
-    
-    const Message Subscription::nextMessage(const int timeout)
+
+    Subscription Client::queueSubscribe(const std::string& subject, const std::string& group,
+                                        const SubscribeOptions& options)
     {
-        // if queue empty launch wait timeout
-        // sinon get value
-        // futur.get()
-        if(m_queue.empty()){
-            // launch timeout
+        Subscription sub;
+        sub.m_state = SubscriptionState::create(m_conn, subject.c_str(), group, options, subscriptionContext());
+        return sub;
+    }
+
+    Subscription Client::queueSubscribe(const std::string& subject, const std::string& group, MessageHandler handler,
+                                        const SubscribeOptions& options)
+    {
+        if (!handler) {
+            throw Exception(NATS_INVALID_ARG);
         }
-        
-        return Message();
+        Subscription sub;
+        sub.m_state = SubscriptionState::create(m_conn, subject.c_str(), group, options, subscriptionContext(),
+                                                std::move(handler));
+        return sub;
     }
 
     Message Client::request(const Message& message, int timeout)
@@ -304,34 +699,64 @@ namespace CppNats {
         if (err != NATS_OK) {
             throw Exception(err);
         }
-        Message reply;
-        reply.setMsg(replyMsg); 
-        return reply;
+        return Message(replyMsg);
     }
 
-   /*  std::future<Message> Client::requestAsync(const Message& message, int timeout)
+    std::shared_ptr<RequestMux> Client::mux()
     {
-        std::promise<Message> promise;
-        auto future = promise.get_future();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_conn) {
+            throw Exception(NATS_CONNECTION_CLOSED);
+        }
+        if (!m_mux) {
+            m_mux = RequestMux::create(m_conn, m_timer);
+        }
+        return m_mux;
+    }
 
-        auto callback = [](natsConnection* nc, natsSubscription* sub, natsMsg* msg, void* closure) {
-            std::promise<Message>* p = static_cast<std::promise<Message>*>(closure);
-            if (msg) {
-                Message reply;
-                reply.setMsg(msg);
-                p->set_value(reply);
-            } else {
-                p->set_exception(std::make_exception_ptr(Exception(NATS_ERR)));
-            }
-        };
+    std::future<Message> Client::requestAsync(const Message& message, int timeout)
+    {
+        return requestAsync(message.subject(), message.data(), timeout);
+    }
 
-        auto err = natsConnection_RequestMsg(m_conn, callback, &promise, message.getNatsMsg(), timeout);
+    std::future<Message> Client::requestAsync(std::string_view subject, std::string_view data, int timeout)
+    {
+        auto promise = std::make_shared<std::promise<Message>>();
+        auto future = promise->get_future();
+        mux()->request(subject, std::as_bytes(std::span<const char>(data.data(), data.size())), timeout,
+            [promise](natsStatus status, Message&& reply) {
+                if (status == NATS_OK) {
+                    promise->set_value(std::move(reply));
+                } else {
+                    promise->set_exception(std::make_exception_ptr(Exception(status)));
+                }
+            });
+        return future;
+    }
+
+    RequestAwaiter Client::requestAwait(const Message& message, int timeout)
+    {
+        return requestAwait(message.subject(), message.data(), timeout);
+    }
+
+    RequestAwaiter Client::requestAwait(std::string_view subject, std::string_view data, int timeout)
+    {
+        return RequestAwaiter(mux(), subject, std::as_bytes(std::span<const char>(data.data(), data.size())),
+                              timeout, false);
+    }
+
+    void Client::flush(int timeout)
+    {
+        auto err = natsConnection_FlushTimeout(m_conn, timeout);
         if (err != NATS_OK) {
             throw Exception(err);
         }
+    }
 
-        return future;
-    }   */ 
+    FlushAwaiter Client::flushAwait(int timeout)
+    {
+        return FlushAwaiter(mux(), std::string_view(), std::span<const std::byte>(), timeout, true);
+    }
 
 
 } // namespace CppNats
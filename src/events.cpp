@@ -0,0 +1,111 @@
+/**
+ * @file events.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include "cppnats.hpp"
+#include "events.hpp"
+#include "subscription.hpp"
+
+
+namespace CppNats {
+
+    namespace {
+
+        template<typename Handler, typename... Args>
+        void notify(const Handler& handler, Args... args) noexcept
+        {
+            if (!handler) {
+                return;
+            }
+            try {
+                handler(args...);
+            } catch (...) {
+                // an exception must not unwind through cnats
+            }
+        }
+
+    } // namespace
+
+    void* ConnectionEvents::install(natsOptions* opts, const std::shared_ptr<ConnectionEvents>& events)
+    {
+        auto closure = new std::shared_ptr<ConnectionEvents>(events);
+        auto err = natsOptions_SetErrorHandler(opts, onError, closure);
+        if (err == NATS_OK) {
+            err = natsOptions_SetDisconnectedCB(opts, onDisconnected, closure);
+        }
+        if (err == NATS_OK) {
+            err = natsOptions_SetReconnectedCB(opts, onReconnected, closure);
+        }
+        if (err == NATS_OK) {
+            err = natsOptions_SetClosedCB(opts, onClosed, closure);
+        }
+        if (err != NATS_OK) {
+            release(closure);
+            throw Exception(err);
+        }
+        return closure;
+    }
+
+    void ConnectionEvents::release(void* closure)
+    {
+        delete static_cast<std::shared_ptr<ConnectionEvents>*>(closure);
+    }
+
+    void ConnectionEvents::track(natsSubscription* sub, const std::shared_ptr<SubscriptionState>& state)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_subscriptions.insert_or_assign(sub, state);
+    }
+
+    void ConnectionEvents::untrack(natsSubscription* sub)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_subscriptions.erase(sub);
+    }
+
+    void ConnectionEvents::onError(natsConnection*, natsSubscription* sub, natsStatus err, void* closure)
+    {
+        auto& events = *static_cast<std::shared_ptr<ConnectionEvents>*>(closure);
+        if (err == NATS_SLOW_CONSUMER && sub) {
+            std::shared_ptr<SubscriptionState> state;
+            {
+                std::lock_guard<std::mutex> lock(events->m_mutex);
+                auto it = events->m_subscriptions.find(sub);
+                if (it != events->m_subscriptions.end()) {
+                    state = it->second.lock();
+                }
+            }
+            if (state) {
+                state->reportSlowConsumer();
+            }
+        }
+        notify(events->errorHandler, static_cast<Status>(err));
+    }
+
+    void ConnectionEvents::onDisconnected(natsConnection*, void* closure)
+    {
+        auto& events = *static_cast<std::shared_ptr<ConnectionEvents>*>(closure);
+        notify(events->disconnectedHandler);
+    }
+
+    void ConnectionEvents::onReconnected(natsConnection*, void* closure)
+    {
+        auto& events = *static_cast<std::shared_ptr<ConnectionEvents>*>(closure);
+        notify(events->reconnectedHandler);
+    }
+
+    void ConnectionEvents::onClosed(natsConnection*, void* closure)
+    {
+        notify((*static_cast<std::shared_ptr<ConnectionEvents>*>(closure))->closedHandler);
+        release(closure);
+    }
+
+} // namespace CppNats
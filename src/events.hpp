@@ -0,0 +1,54 @@
+/**
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+#include <nats.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "cppnats.hpp"
+
+namespace CppNats {
+
+    class SubscriptionState;
+
+    // Receives the asynchronous connection callbacks of cnats for one client.
+    // cnats keeps a reference to it until the connection's closed callback,
+    // which is always the last one.
+    class ConnectionEvents
+    {
+        public:
+            // Installs the callbacks on opts before connecting. If the connection
+            // cannot be established, the returned closure must be given to release().
+            static void* install(natsOptions* opts, const std::shared_ptr<ConnectionEvents>& events);
+            static void release(void* closure);
+
+            // Subscriptions to notify about slow consumer errors reported by cnats.
+            void track(natsSubscription* sub, const std::shared_ptr<SubscriptionState>& state);
+            void untrack(natsSubscription* sub);
+
+            // Application callbacks from Options, set before install().
+            ConnectionHandler disconnectedHandler;
+            ConnectionHandler reconnectedHandler;
+            ConnectionHandler closedHandler;
+            ConnectionErrorHandler errorHandler;
+
+        private:
+            static void onError(natsConnection* nc, natsSubscription* sub, natsStatus err, void* closure);
+            static void onDisconnected(natsConnection* nc, void* closure);
+            static void onReconnected(natsConnection* nc, void* closure);
+            static void onClosed(natsConnection* nc, void* closure);
+
+            std::mutex m_mutex;
+            std::unordered_map<natsSubscription*, std::weak_ptr<SubscriptionState>> m_subscriptions;
+    };
+
+} // namespace CppNats
@@ -0,0 +1,110 @@
+/**
+ * @file flow.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <algorithm>
+#include "flow.hpp"
+#include "timer.hpp"
+
+
+namespace CppNats {
+
+    namespace {
+
+        // while above the high watermark, in milliseconds: the interval doubles up to
+        // MaxPollInterval so that a long congestion does not keep the timer thread busy
+        constexpr int MinPollInterval = 1;
+        constexpr int MaxPollInterval = 64;
+
+        void notify(const WatermarkHandler& handler, bool above) noexcept
+        {
+            try {
+                handler(above);
+            } catch (...) {
+                // there is nobody to report to on the timer thread
+            }
+        }
+
+    } // namespace
+
+    FlowControl::FlowControl(natsConnection* conn, std::size_t high, std::size_t low, WatermarkHandler handler,
+                             std::shared_ptr<TimerService> timer)
+        : m_conn(conn), m_high(high), m_low(low), m_handler(std::move(handler)), m_timer(std::move(timer))
+    {
+    }
+
+    void FlowControl::detach() noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_conn = nullptr;
+        // the buffered bytes are gone with the connection, and poll() stops here
+        if (m_above.load()) {
+            notify(m_handler, false);
+            m_above.store(false);
+        }
+    }
+
+    // Notifications are made under m_mutex so that they arrive in order, while
+    // m_above is true so that a handler publishing does not take it again.
+
+    void FlowControl::checkHigh() noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_conn || m_above.load()) {
+            return;
+        }
+        int buffered = natsConnection_Buffered(m_conn);
+        if (buffered < 0 || static_cast<std::size_t>(buffered) < m_high) {
+            return;
+        }
+        m_above.store(true);
+        notify(m_handler, true);
+        m_interval = MinPollInterval;
+        schedule();
+    }
+
+    void FlowControl::poll() noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_conn) {
+            return;
+        }
+        // negative once closed, detach() is about to be called
+        int buffered = natsConnection_Buffered(m_conn);
+        if (buffered < 0) {
+            return;
+        }
+        if (static_cast<std::size_t>(buffered) > m_low) {
+            m_interval = std::min(m_interval * 2, MaxPollInterval);
+            schedule();
+            return;
+        }
+        notify(m_handler, false);
+        m_above.store(false);
+    }
+
+    // Called with m_mutex held.
+    void FlowControl::schedule() noexcept
+    {
+        try {
+            m_timer->schedule(m_interval, [weak = weak_from_this()] {
+                if (auto self = weak.lock()) {
+                    self->poll();
+                }
+            });
+        } catch (...) {
+            // rather than leaving the producer throttled for good
+            notify(m_handler, false);
+            m_above.store(false);
+        }
+    }
+
+} // namespace CppNats
@@ -0,0 +1,65 @@
+/**
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+
+#pragma once
+#include <nats.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include "cppnats.hpp"
+
+namespace CppNats {
+
+    class TimerService;
+
+    // Write watermarks of one client, see Options::setWriteWatermarks().
+    // Each publish compares the buffered bytes to the high watermark. Once it is
+    // reached, nothing tells when cnats has written the bytes out, so the timer
+    // service polls them, less and less often, until they drain to the low watermark.
+    class FlowControl : public std::enable_shared_from_this<FlowControl>
+    {
+        public:
+            FlowControl(natsConnection* conn, std::size_t high, std::size_t low, WatermarkHandler handler,
+                        std::shared_ptr<TimerService> timer);
+
+            // After a successful publish, on the publishing thread.
+            void check() noexcept
+            {
+                if (!m_above.load(std::memory_order_relaxed)) {
+                    checkHigh();
+                }
+            }
+
+            bool above() const noexcept { return m_above.load(std::memory_order_relaxed); }
+
+            // The connection is being closed: stops polling. If above the high watermark,
+            // the handler is called a last time with false. Must not be called from the handler.
+            void detach() noexcept;
+
+        private:
+            void checkHigh() noexcept;
+            void poll() noexcept;
+            void schedule() noexcept;
+
+            std::mutex m_mutex;
+            natsConnection* m_conn;
+            const std::size_t m_high;
+            const std::size_t m_low;
+            WatermarkHandler m_handler;
+            std::shared_ptr<TimerService> m_timer;
+            // milliseconds until the next poll, guarded by m_mutex
+            int m_interval = 0;
+            std::atomic<bool> m_above{false};
+    };
+
+} // namespace CppNats
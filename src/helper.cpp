@@ -8,19 +8,14 @@
  * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
  * See the License for the specific language governing permissions and limitations under the License.
  */
-#include <regex>
+#include "cppnats.hpp"
 #include "helper.hpp"
 
 namespace CppNats {
 
     bool Helper::urlIsValid(const std::string& url)
     {
-        static const std::regex pattern(
-            R"(^(nats|nats-tls)://([^@]+@)?([a-zA-Z0-9]([a-zA-Z0-9.-]*[a-zA-Z0-9])?)(:[0-9]{1,5})?$)",
-            std::regex::icase
-        );
-
-        return std::regex_match(url, pattern);
+        return ServerUrl::parse(url).has_value();
     }
 
 } // namespace CppNats
@@ -11,6 +11,8 @@
 
 #pragma once
 #include <string>
+#include <string_view>
+#include <cstring>
 
 
 namespace CppNats {
@@ -21,4 +23,31 @@ namespace CppNats {
             static bool urlIsValid(const std::string& url);
     };
 
+    // NUL-terminated copy of a string_view for the cnats API.
+    // Short strings (subjects, inboxes) stay on the stack.
+    class CString
+    {
+        public:
+            explicit CString(std::string_view str)
+            {
+                if (str.size() < sizeof(m_buffer)) {
+                    std::memcpy(m_buffer, str.data(), str.size());
+                    m_buffer[str.size()] = '\0';
+                    m_str = m_buffer;
+                } else {
+                    m_heap.assign(str);
+                    m_str = m_heap.c_str();
+                }
+            }
+            CString(const CString&) = delete;
+            CString& operator=(const CString&) = delete;
+
+            const char* c_str() const noexcept { return m_str; }
+
+        private:
+            char m_buffer[256];
+            std::string m_heap;
+            const char* m_str;
+    };
+
 } // namespace CppNats
\ No newline at end of file
@@ -0,0 +1,348 @@
+/**
+ * @file jetstream.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <vector>
+#include "cppnats.hpp"
+#include "helper.hpp"
+#include "jetstream.hpp"
+
+
+namespace CppNats {
+
+    void throwJetStream(natsStatus err, jsErrCode code)
+    {
+        natsStatus last = NATS_OK;
+        const char* text = nats_GetLastError(&last);
+        if (last == err && text) {
+            throw JetStreamException(err, code, text);
+        }
+        throw JetStreamException(err, code);
+    }
+
+    static PubAck toPubAck(const jsPubAck* pa)
+    {
+        PubAck ack;
+        ack.stream = pa->Stream ? pa->Stream : "";
+        ack.sequence = pa->Sequence;
+        ack.duplicate = pa->Duplicate;
+        return ack;
+    }
+
+    JetStream Client::jetStream()
+    {
+        return jetStream(JetStreamOptions());
+    }
+
+    JetStream Client::jetStream(const JetStreamOptions& options)
+    {
+        JetStream js;
+        js.m_state = JetStreamState::create(m_conn, options);
+        return js;
+    }
+
+    namespace {
+
+        // The ack handler closure of a jsCtx is an id in this registry rather than a
+        // pointer: cnats gives no signal once its last ack handler has returned, so a
+        // late ack must find nothing instead of freed memory.
+        struct AckRegistry
+        {
+            std::mutex mutex;
+            uint64_t lastId = 0;
+            std::unordered_map<uint64_t, std::weak_ptr<AckTable>> tables;
+        };
+
+        // never destroyed, acks may still arrive while the program exits
+        AckRegistry& ackRegistry()
+        {
+            static auto registry = new AckRegistry();
+            return *registry;
+        }
+
+    } // namespace
+
+    std::shared_ptr<JetStreamState> JetStreamState::create(natsConnection* conn, const JetStreamOptions& options)
+    {
+        auto state = std::make_shared<JetStreamState>();
+        state->timeout = options.timeout;
+        {
+            auto& registry = ackRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            state->m_ackId = ++registry.lastId;
+            registry.tables.emplace(state->m_ackId, state->acks);
+        }
+        jsOptions opts;
+        jsOptions_Init(&opts);
+        // cnats copies the strings
+        opts.Prefix = options.prefix.empty() ? nullptr : options.prefix.c_str();
+        opts.Domain = options.domain.empty() ? nullptr : options.domain.c_str();
+        opts.Wait = options.timeout;
+        opts.PublishAsync.MaxPending = options.maxPendingAcks;
+        opts.PublishAsync.StallWait = options.stallWait;
+        opts.PublishAsync.AckHandler = onAck;
+        opts.PublishAsync.AckHandlerClosure = reinterpret_cast<void*>(static_cast<uintptr_t>(state->m_ackId));
+        auto err = natsConnection_JetStream(&state->js, conn, &opts);
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        return state;
+    }
+
+    JetStreamState::~JetStreamState()
+    {
+        if (js) {
+            // gives the outstanding acks a chance to complete normally
+            waitForAcks(timeout);
+        }
+        if (m_ackId) {
+            // from now on, late acks only release their message
+            auto& registry = ackRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.tables.erase(m_ackId);
+        }
+        if (js) {
+            jsCtx_Destroy(js);
+        }
+        std::unordered_map<natsMsg*, PubAckHandler> abandonedAcks;
+        {
+            // an ack handler may still be running on this table, it removed its own entry
+            std::lock_guard<std::mutex> lock(acks->mutex);
+            abandonedAcks.swap(acks->pending);
+        }
+        JetStreamException abandoned(NATS_TIMEOUT);
+        for (auto& [msg, handler] : abandonedAcks) {
+            try {
+                handler(PubAck(), &abandoned);
+            } catch (...) {
+            }
+        }
+    }
+
+    void JetStreamState::publishAsync(natsMsg* msg, PubAckHandler handler)
+    {
+        {
+            // registered first, the ack may arrive before js_PublishMsgAsync returns
+            std::lock_guard<std::mutex> lock(acks->mutex);
+            acks->pending.emplace(msg, std::move(handler));
+        }
+        natsMsg* owned = msg;
+        auto err = js_PublishMsgAsync(js, &owned, nullptr);
+        if (err != NATS_OK) {
+            {
+                std::lock_guard<std::mutex> lock(acks->mutex);
+                acks->pending.erase(msg);
+            }
+            // cnats only takes the message on success
+            natsMsg_Destroy(owned);
+            throwJetStream(err);
+        }
+    }
+
+    natsStatus JetStreamState::waitForAcks(int timeout)
+    {
+        if (timeout <= 0) {
+            return NATS_INVALID_TIMEOUT;
+        }
+        jsPubOptions opts;
+        jsPubOptions_Init(&opts);
+        opts.MaxWait = timeout;
+        return js_PublishAsyncComplete(js, &opts);
+    }
+
+    void JetStreamState::onAck(jsCtx*, natsMsg* msg, jsPubAck* pa, jsPubAckErr* pae, void* closure)
+    {
+        auto id = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(closure));
+        std::shared_ptr<AckTable> table;
+        {
+            auto& registry = ackRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            auto it = registry.tables.find(id);
+            if (it != registry.tables.end()) {
+                table = it->second.lock();
+            }
+        }
+        PubAckHandler handler;
+        if (table) {
+            std::lock_guard<std::mutex> lock(table->mutex);
+            auto it = table->pending.find(msg);
+            if (it != table->pending.end()) {
+                handler = std::move(it->second);
+                table->pending.erase(it);
+            }
+        }
+        // the ack handler owns the published message
+        natsMsg_Destroy(msg);
+        if (!handler) {
+            return;
+        }
+        try {
+            if (pa) {
+                handler(toPubAck(pa), nullptr);
+            } else {
+                JetStreamException error(pae ? pae->Err : NATS_ERR, pae ? pae->ErrCode : static_cast<jsErrCode>(0),
+                                         pae && pae->ErrText ? pae->ErrText : "");
+                handler(PubAck(), &error);
+            }
+        } catch (...) {
+            // must not unwind through cnats
+        }
+    }
+
+    static JetStreamState& stateOf(const std::shared_ptr<JetStreamState>& state)
+    {
+        if (!state) {
+            throw Exception(NATS_ILLEGAL_STATE);
+        }
+        return *state;
+    }
+
+    void JetStream::addStream(const StreamConfig& config)
+    {
+        auto& state = stateOf(m_state);
+        jsStreamConfig cfg;
+        jsStreamConfig_Init(&cfg);
+        std::vector<const char*> subjects;
+        subjects.reserve(config.subjects.size());
+        for (auto& subject : config.subjects) {
+            subjects.push_back(subject.c_str());
+        }
+        cfg.Name = config.name.c_str();
+        cfg.Subjects = subjects.data();
+        cfg.SubjectsLen = static_cast<int>(subjects.size());
+        cfg.Storage = static_cast<jsStorageType>(config.storage);
+        cfg.MaxMsgs = config.maxMsgs;
+        cfg.MaxBytes = config.maxBytes;
+        cfg.MaxMsgsPerSubject = config.maxMsgsPerSubject;
+        jsStreamInfo* info = nullptr;
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_AddStream(&info, state.js, &cfg, nullptr, &code);
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+        jsStreamInfo_Destroy(info);
+    }
+
+    void JetStream::deleteStream(const std::string& name)
+    {
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_DeleteStream(stateOf(m_state).js, name.c_str(), nullptr, &code);
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+    }
+
+    void JetStream::purgeStream(const std::string& name)
+    {
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_PurgeStream(stateOf(m_state).js, name.c_str(), nullptr, &code);
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+    }
+
+    StreamInfo JetStream::streamInfo(const std::string& name)
+    {
+        jsStreamInfo* info = nullptr;
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_GetStreamInfo(&info, stateOf(m_state).js, name.c_str(), nullptr, &code);
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+        StreamInfo result;
+        result.name = name;
+        result.msgs = info->State.Msgs;
+        result.bytes = info->State.Bytes;
+        result.firstSeq = info->State.FirstSeq;
+        result.lastSeq = info->State.LastSeq;
+        jsStreamInfo_Destroy(info);
+        return result;
+    }
+
+    PubAck JetStream::publish(std::string_view subject, std::string_view data)
+    {
+        CString subj(subject);
+        jsPubAck* pa = nullptr;
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_Publish(&pa, stateOf(m_state).js, subj.c_str(), data.data(), static_cast<int>(data.size()),
+                              nullptr, &code);
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+        PubAck ack = toPubAck(pa);
+        jsPubAck_Destroy(pa);
+        return ack;
+    }
+
+    PubAck JetStream::publish(const Message& message)
+    {
+        jsPubAck* pa = nullptr;
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_PublishMsg(&pa, stateOf(m_state).js, message.getNatsMsg(), nullptr, &code);
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+        PubAck ack = toPubAck(pa);
+        jsPubAck_Destroy(pa);
+        return ack;
+    }
+
+    void JetStream::publishAsync(std::string_view subject, std::string_view data, PubAckHandler handler)
+    {
+        auto& state = stateOf(m_state);
+        CString subj(subject);
+        natsMsg* msg = nullptr;
+        auto err = natsMsg_Create(&msg, subj.c_str(), nullptr, data.data(), static_cast<int>(data.size()));
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+        state.publishAsync(msg, std::move(handler));
+    }
+
+    void JetStream::publishAsync(Message&& message, PubAckHandler handler)
+    {
+        auto& state = stateOf(m_state);
+        if (message.empty()) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        state.publishAsync(message.release(), std::move(handler));
+    }
+
+    std::future<PubAck> JetStream::publishAsync(std::string_view subject, std::string_view data)
+    {
+        auto promise = std::make_shared<std::promise<PubAck>>();
+        auto future = promise->get_future();
+        publishAsync(subject, data, [promise](const PubAck& ack, const JetStreamException* error) {
+            if (error) {
+                promise->set_exception(std::make_exception_ptr(*error));
+            } else {
+                promise->set_value(ack);
+            }
+        });
+        return future;
+    }
+
+    void JetStream::waitForAcks(int timeout)
+    {
+        auto err = stateOf(m_state).waitForAcks(timeout);
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+    }
+
+    std::size_t JetStream::pendingAcks() const
+    {
+        auto& state = stateOf(m_state);
+        std::lock_guard<std::mutex> lock(state.acks->mutex);
+        return state.acks->pending.size();
+    }
+
+} // namespace CppNats
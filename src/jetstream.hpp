@@ -0,0 +1,61 @@
+/**
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+#include <nats.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "cppnats.hpp"
+
+namespace CppNats {
+
+    // Throws a JetStreamException carrying the last cnats error text of this thread.
+    [[noreturn]] void throwJetStream(natsStatus err, jsErrCode code = static_cast<jsErrCode>(0));
+
+    // publishAsync() completions, keyed by the message given to cnats. Shared with
+    // the ack handler, which may still be running when the JetStreamState is gone.
+    struct AckTable
+    {
+        std::mutex mutex;
+        std::unordered_map<natsMsg*, PubAckHandler> pending;
+    };
+
+    // The jsCtx of a JetStream handle and the completions of its asynchronous publishes.
+    class JetStreamState
+    {
+        public:
+            static std::shared_ptr<JetStreamState> create(natsConnection* conn, const JetStreamOptions& options);
+            ~JetStreamState();
+
+            JetStreamState() = default;
+            JetStreamState(const JetStreamState&) = delete;
+            JetStreamState& operator=(const JetStreamState&) = delete;
+
+            // Takes ownership of msg, also when it throws.
+            void publishAsync(natsMsg* msg, PubAckHandler handler);
+            // Returns NATS_TIMEOUT if acks are still pending after timeout.
+            natsStatus waitForAcks(int timeout);
+
+            jsCtx* js = nullptr;
+            int timeout = 5000;
+
+            std::shared_ptr<AckTable> acks = std::make_shared<AckTable>();
+
+        private:
+            static void onAck(jsCtx* js, natsMsg* msg, jsPubAck* pa, jsPubAckErr* pae, void* closure);
+
+            // key of acks in the registry read by onAck(), 0 if not registered
+            uint64_t m_ackId = 0;
+    };
+
+} // namespace CppNats
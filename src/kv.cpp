@@ -0,0 +1,329 @@
+/**
+ * @file kv.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "cppnats.hpp"
+#include "helper.hpp"
+#include "jetstream.hpp"
+
+
+namespace CppNats {
+
+    class KeyValueState
+    {
+        public:
+            ~KeyValueState()
+            {
+                if (cacheWatcher) {
+                    // makes kvWatcher_Next() fail, so the cache thread returns
+                    kvWatcher_Stop(cacheWatcher);
+                    cacheThread.join();
+                    kvWatcher_Destroy(cacheWatcher);
+                }
+                kvStore_Destroy(kv);
+            }
+
+            kvStore* kv = nullptr;
+            // keeps the jsCtx alive
+            std::shared_ptr<JetStreamState> js;
+
+            std::mutex cacheMutex;
+            kvWatcher* cacheWatcher = nullptr;
+            std::thread cacheThread;
+            // replaced as a whole by the cache thread, readers never wait for a rebuild
+            std::atomic<std::shared_ptr<const KeyValueSnapshot>> snapshot;
+
+            void runCache();
+    };
+
+    class KeyValueWatcherState
+    {
+        public:
+            ~KeyValueWatcherState() { kvWatcher_Destroy(watcher); }
+
+            kvWatcher* watcher = nullptr;
+            std::shared_ptr<KeyValueState> kv;
+    };
+
+    static KeyValueEntry toEntry(kvEntry* entry)
+    {
+        KeyValueEntry result;
+        result.key = kvEntry_Key(entry);
+        auto value = static_cast<const char*>(kvEntry_Value(entry));
+        if (value) {
+            result.value.assign(value, kvEntry_ValueLen(entry));
+        }
+        result.revision = kvEntry_Revision(entry);
+        result.operation = static_cast<KeyValueOp>(kvEntry_Operation(entry));
+        return result;
+    }
+
+    void KeyValueState::runCache()
+    {
+        KeyValueSnapshot current;
+        bool loaded = false;
+        while (true) {
+            kvEntry* entry = nullptr;
+            auto err = kvWatcher_Next(&entry, cacheWatcher, 1000);
+            if (err == NATS_TIMEOUT) {
+                continue;
+            }
+            if (err != NATS_OK) {
+                // stopped, or the watch failed: nothing keeps the snapshot up to date
+                // any more, get() goes back to the server
+                snapshot.store(nullptr);
+                return;
+            }
+            if (entry) {
+                KeyValueEntry update = toEntry(entry);
+                kvEntry_Destroy(entry);
+                if (update.operation == KeyValueOp::Put) {
+                    current.insert_or_assign(update.key, std::move(update));
+                } else {
+                    current.erase(update.key);
+                }
+                if (!loaded) {
+                    // the initial values are published at once, below
+                    continue;
+                }
+            } else {
+                // end of the current values
+                loaded = true;
+            }
+            snapshot.store(std::make_shared<const KeyValueSnapshot>(current));
+        }
+    }
+
+    KeyValue JetStream::createKeyValue(const KeyValueConfig& config)
+    {
+        if (!m_state) {
+            throw Exception(NATS_ILLEGAL_STATE);
+        }
+        kvConfig cfg;
+        kvConfig_Init(&cfg);
+        cfg.Bucket = config.bucket.c_str();
+        cfg.History = config.history;
+        // nanoseconds
+        cfg.TTL = config.ttl * 1000000;
+        cfg.MaxBytes = config.maxBytes;
+        cfg.MaxValueSize = config.maxValueSize;
+        cfg.StorageType = static_cast<jsStorageType>(config.storage);
+        auto state = std::make_shared<KeyValueState>();
+        state->js = m_state;
+        auto err = js_CreateKeyValue(&state->kv, m_state->js, &cfg);
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        KeyValue kv;
+        kv.m_state = std::move(state);
+        return kv;
+    }
+
+    KeyValue JetStream::keyValue(const std::string& bucket)
+    {
+        if (!m_state) {
+            throw Exception(NATS_ILLEGAL_STATE);
+        }
+        auto state = std::make_shared<KeyValueState>();
+        state->js = m_state;
+        auto err = js_KeyValue(&state->kv, m_state->js, bucket.c_str());
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        KeyValue kv;
+        kv.m_state = std::move(state);
+        return kv;
+    }
+
+    void JetStream::deleteKeyValue(const std::string& bucket)
+    {
+        if (!m_state) {
+            throw Exception(NATS_ILLEGAL_STATE);
+        }
+        auto err = js_DeleteKeyValue(m_state->js, bucket.c_str());
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+    }
+
+    static KeyValueState& stateOf(const std::shared_ptr<KeyValueState>& state)
+    {
+        if (!state) {
+            throw Exception(NATS_ILLEGAL_STATE);
+        }
+        return *state;
+    }
+
+    std::optional<KeyValueEntry> KeyValue::get(std::string_view key) const
+    {
+        auto& state = stateOf(m_state);
+        if (auto cached = state.snapshot.load()) {
+            auto it = cached->find(key);
+            if (it == cached->end()) {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+        CString k(key);
+        kvEntry* entry = nullptr;
+        auto err = kvStore_Get(&entry, state.kv, k.c_str());
+        if (err == NATS_NOT_FOUND) {
+            return std::nullopt;
+        }
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        KeyValueEntry result = toEntry(entry);
+        kvEntry_Destroy(entry);
+        return result;
+    }
+
+    uint64_t KeyValue::put(std::string_view key, std::string_view value)
+    {
+        CString k(key);
+        uint64_t revision = 0;
+        auto err = kvStore_Put(&revision, stateOf(m_state).kv, k.c_str(), value.data(), static_cast<int>(value.size()));
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        return revision;
+    }
+
+    uint64_t KeyValue::create(std::string_view key, std::string_view value)
+    {
+        CString k(key);
+        uint64_t revision = 0;
+        auto err = kvStore_Create(&revision, stateOf(m_state).kv, k.c_str(), value.data(),
+                                  static_cast<int>(value.size()));
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        return revision;
+    }
+
+    uint64_t KeyValue::update(std::string_view key, std::string_view value, uint64_t lastRevision)
+    {
+        CString k(key);
+        uint64_t revision = 0;
+        auto err = kvStore_Update(&revision, stateOf(m_state).kv, k.c_str(), value.data(),
+                                  static_cast<int>(value.size()), lastRevision);
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        return revision;
+    }
+
+    void KeyValue::remove(std::string_view key)
+    {
+        CString k(key);
+        auto err = kvStore_Delete(stateOf(m_state).kv, k.c_str());
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+    }
+
+    void KeyValue::purge(std::string_view key)
+    {
+        CString k(key);
+        auto err = kvStore_Purge(stateOf(m_state).kv, k.c_str(), nullptr);
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+    }
+
+    KeyValueWatcher KeyValue::watch(std::string_view keys)
+    {
+        auto watcher = std::make_shared<KeyValueWatcherState>();
+        watcher->kv = m_state;
+        CString k(keys);
+        auto err = kvStore_Watch(&watcher->watcher, stateOf(m_state).kv, k.c_str(), nullptr);
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        KeyValueWatcher result;
+        result.m_state = std::move(watcher);
+        return result;
+    }
+
+    void KeyValue::enableCache()
+    {
+        auto& state = stateOf(m_state);
+        std::lock_guard<std::mutex> lock(state.cacheMutex);
+        if (state.cacheWatcher) {
+            return;
+        }
+        // expired entries are not reported to watchers, the cache would keep them forever
+        kvStatus* status = nullptr;
+        auto err = kvStore_Status(&status, state.kv);
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        int64_t ttl = kvStatus_TTL(status);
+        kvStatus_Destroy(status);
+        if (ttl > 0) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        err = kvStore_WatchAll(&state.cacheWatcher, state.kv, nullptr);
+        if (err != NATS_OK) {
+            throwJetStream(err);
+        }
+        state.cacheThread = std::thread(&KeyValueState::runCache, &state);
+    }
+
+    std::shared_ptr<const KeyValueSnapshot> KeyValue::snapshot() const
+    {
+        return stateOf(m_state).snapshot.load();
+    }
+
+    KeyValueWatcher::~KeyValueWatcher()
+    {
+        stop();
+    }
+
+    KeyValueWatcher& KeyValueWatcher::operator=(KeyValueWatcher&& other) noexcept
+    {
+        if (this != &other) {
+            stop();
+            m_state = std::move(other.m_state);
+        }
+        return *this;
+    }
+
+    KeyValueEntry KeyValueWatcher::next(int timeout)
+    {
+        if (!m_state) {
+            throw Exception(NATS_INVALID_SUBSCRIPTION);
+        }
+        kvEntry* entry = nullptr;
+        auto err = kvWatcher_Next(&entry, m_state->watcher, timeout);
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+        if (!entry) {
+            return KeyValueEntry();
+        }
+        KeyValueEntry result = toEntry(entry);
+        kvEntry_Destroy(entry);
+        return result;
+    }
+
+    void KeyValueWatcher::stop() noexcept
+    {
+        if (m_state) {
+            kvWatcher_Stop(m_state->watcher);
+            m_state.reset();
+        }
+    }
+
+} // namespace CppNats
@@ -0,0 +1,776 @@
+/**
+ * @file object.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <unordered_map>
+#include <unistd.h>
+#include "cppnats.hpp"
+#include "jetstream.hpp"
+
+// cnats has no object store API, so this one is built on streams and pull consumers.
+
+namespace CppNats {
+
+    static std::string streamName(const std::string& bucket)
+    {
+        return "OBJ_" + bucket;
+    }
+
+    static std::string chunkSubject(const std::string& bucket, const std::string& nuid)
+    {
+        return "$O." + bucket + ".C." + nuid;
+    }
+
+    // Object names may contain characters not allowed in subjects.
+    static std::string base64Url(std::string_view in)
+    {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        std::string out;
+        out.reserve((in.size() + 2) / 3 * 4);
+        std::size_t i = 0;
+        for (; i + 2 < in.size(); i += 3) {
+            uint32_t n = (uint8_t(in[i]) << 16) | (uint8_t(in[i + 1]) << 8) | uint8_t(in[i + 2]);
+            out += alphabet[(n >> 18) & 63];
+            out += alphabet[(n >> 12) & 63];
+            out += alphabet[(n >> 6) & 63];
+            out += alphabet[n & 63];
+        }
+        if (i + 1 == in.size()) {
+            uint32_t n = uint8_t(in[i]) << 16;
+            out += alphabet[(n >> 18) & 63];
+            out += alphabet[(n >> 12) & 63];
+            out += "==";
+        } else if (i + 2 == in.size()) {
+            uint32_t n = (uint8_t(in[i]) << 16) | (uint8_t(in[i + 1]) << 8);
+            out += alphabet[(n >> 18) & 63];
+            out += alphabet[(n >> 12) & 63];
+            out += alphabet[(n >> 6) & 63];
+            out += '=';
+        }
+        return out;
+    }
+
+    // SHA-256 (FIPS 180-4) of an object, fed chunk by chunk.
+    class Sha256
+    {
+        public:
+            void update(std::span<const std::byte> data)
+            {
+                for (std::byte b : data) {
+                    m_block[m_used++] = static_cast<uint8_t>(b);
+                    if (m_used == sizeof(m_block)) {
+                        compress();
+                        m_used = 0;
+                    }
+                }
+                m_length += data.size();
+            }
+
+            std::string digest()
+            {
+                uint64_t bits = m_length * 8;
+                uint8_t pad = 0x80;
+                update(std::as_bytes(std::span<const uint8_t>(&pad, 1)));
+                pad = 0;
+                while (m_used != 56) {
+                    update(std::as_bytes(std::span<const uint8_t>(&pad, 1)));
+                }
+                for (int i = 7; i >= 0; --i) {
+                    m_block[m_used++] = static_cast<uint8_t>(bits >> (i * 8));
+                }
+                compress();
+                std::string out(32, '\0');
+                for (int i = 0; i < 32; ++i) {
+                    out[i] = static_cast<char>(m_state[i / 4] >> (24 - (i % 4) * 8));
+                }
+                return out;
+            }
+
+        private:
+            static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+            void compress()
+            {
+                static const uint32_t k[64] = {
+                    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+                uint32_t w[64];
+                for (int i = 0; i < 16; ++i) {
+                    w[i] = (uint32_t(m_block[i * 4]) << 24) | (uint32_t(m_block[i * 4 + 1]) << 16) |
+                           (uint32_t(m_block[i * 4 + 2]) << 8) | uint32_t(m_block[i * 4 + 3]);
+                }
+                for (int i = 16; i < 64; ++i) {
+                    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+                }
+                uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+                uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+                for (int i = 0; i < 64; ++i) {
+                    uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+                    uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = d + t1;
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = t1 + t2;
+                }
+                m_state[0] += a;
+                m_state[1] += b;
+                m_state[2] += c;
+                m_state[3] += d;
+                m_state[4] += e;
+                m_state[5] += f;
+                m_state[6] += g;
+                m_state[7] += h;
+            }
+
+            uint32_t m_state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+            uint8_t m_block[64];
+            std::size_t m_used = 0;
+            uint64_t m_length = 0;
+    };
+
+    static std::string digestOf(Sha256& sha)
+    {
+        return "SHA-256=" + base64Url(sha.digest());
+    }
+
+    // A unique id for the chunks of one version of an object, taken from a cnats inbox.
+    static std::string newNuid()
+    {
+        natsInbox* inbox = nullptr;
+        auto err = natsInbox_Create(&inbox);
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+        std::string_view id(inbox);
+        std::string nuid(id.substr(id.rfind('.') + 1));
+        natsInbox_Destroy(inbox);
+        return nuid;
+    }
+
+    // Minimal JSON support for the metadata, which is always a flat object written
+    // by a NATS client.
+    static void appendJsonString(std::string& out, std::string_view str)
+    {
+        out += '"';
+        for (char c : str) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        out += escaped;
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        out += '"';
+    }
+
+    // Minimal JSON reader for the object metadata. Only the members of the top-level
+    // object are looked up, nested objects and arrays are skipped whole. All of them
+    // throw Exception(NATS_ERR) on malformed input.
+    using JsonMembers = std::unordered_map<std::string, std::string_view, KeyHash, std::equal_to<>>;
+
+    static void skipJsonSpace(std::string_view json, std::size_t& pos)
+    {
+        while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\n' || json[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code)
+    {
+        // surrogate pairs are not combined
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    // Decodes the string starting at json[pos], which must be '"', and moves pos past it.
+    static std::string parseJsonString(std::string_view json, std::size_t& pos)
+    {
+        if (pos >= json.size() || json[pos] != '"') {
+            throw Exception(NATS_ERR);
+        }
+        std::string out;
+        for (++pos; pos < json.size(); ++pos) {
+            char c = json[pos];
+            if (c == '"') {
+                ++pos;
+                return out;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                throw Exception(NATS_ERR);
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (++pos >= json.size()) {
+                throw Exception(NATS_ERR);
+            }
+            switch (json[pos]) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    if (pos + 4 >= json.size()) {
+                        throw Exception(NATS_ERR);
+                    }
+                    uint32_t code = 0;
+                    for (char h : json.substr(pos + 1, 4)) {
+                        int digit = h >= '0' && h <= '9' ? h - '0'
+                                  : h >= 'a' && h <= 'f' ? h - 'a' + 10
+                                  : h >= 'A' && h <= 'F' ? h - 'A' + 10 : -1;
+                        if (digit < 0) {
+                            throw Exception(NATS_ERR);
+                        }
+                        code = code * 16 + static_cast<uint32_t>(digit);
+                    }
+                    pos += 4;
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    throw Exception(NATS_ERR);
+            }
+        }
+        // unterminated
+        throw Exception(NATS_ERR);
+    }
+
+    // Moves pos past the value starting at json[pos].
+    static void skipJsonValue(std::string_view json, std::size_t& pos)
+    {
+        if (pos >= json.size()) {
+            throw Exception(NATS_ERR);
+        }
+        if (json[pos] == '"') {
+            parseJsonString(json, pos);
+            return;
+        }
+        if (json[pos] == '{' || json[pos] == '[') {
+            std::string closing;
+            while (pos < json.size()) {
+                char c = json[pos];
+                if (c == '"') {
+                    parseJsonString(json, pos);
+                    continue;
+                }
+                if (c == '{') {
+                    closing += '}';
+                } else if (c == '[') {
+                    closing += ']';
+                } else if (c == '}' || c == ']') {
+                    if (closing.back() != c) {
+                        throw Exception(NATS_ERR);
+                    }
+                    closing.pop_back();
+                    if (closing.empty()) {
+                        ++pos;
+                        return;
+                    }
+                }
+                ++pos;
+            }
+            throw Exception(NATS_ERR);
+        }
+        // number, true, false or null
+        auto start = pos;
+        while (pos < json.size() && std::strchr(",}] \t\n\r", json[pos]) == nullptr) {
+            ++pos;
+        }
+        if (pos == start) {
+            throw Exception(NATS_ERR);
+        }
+    }
+
+    // Members of the top-level object, values are left as JSON text.
+    static JsonMembers parseJsonObject(std::string_view json)
+    {
+        JsonMembers members;
+        std::size_t pos = 0;
+        skipJsonSpace(json, pos);
+        if (pos >= json.size() || json[pos] != '{') {
+            throw Exception(NATS_ERR);
+        }
+        ++pos;
+        skipJsonSpace(json, pos);
+        if (pos < json.size() && json[pos] == '}') {
+            ++pos;
+        } else {
+            while (true) {
+                skipJsonSpace(json, pos);
+                std::string key = parseJsonString(json, pos);
+                skipJsonSpace(json, pos);
+                if (pos >= json.size() || json[pos] != ':') {
+                    throw Exception(NATS_ERR);
+                }
+                ++pos;
+                skipJsonSpace(json, pos);
+                auto start = pos;
+                skipJsonValue(json, pos);
+                members.insert_or_assign(std::move(key), json.substr(start, pos - start));
+                skipJsonSpace(json, pos);
+                if (pos < json.size() && json[pos] == ',') {
+                    ++pos;
+                } else if (pos < json.size() && json[pos] == '}') {
+                    ++pos;
+                    break;
+                } else {
+                    throw Exception(NATS_ERR);
+                }
+            }
+        }
+        skipJsonSpace(json, pos);
+        if (pos != json.size()) {
+            throw Exception(NATS_ERR);
+        }
+        return members;
+    }
+
+    // Empty if the member is missing.
+    static std::string jsonString(const JsonMembers& members, std::string_view key)
+    {
+        auto member = members.find(key);
+        if (member == members.end()) {
+            return {};
+        }
+        std::size_t pos = 0;
+        return parseJsonString(member->second, pos);
+    }
+
+    static uint64_t jsonNumber(const JsonMembers& members, std::string_view key)
+    {
+        auto member = members.find(key);
+        if (member == members.end()) {
+            return 0;
+        }
+        uint64_t value = 0;
+        for (char c : member->second) {
+            if (c < '0' || c > '9') {
+                throw Exception(NATS_ERR);
+            }
+            value = value * 10 + (c - '0');
+        }
+        return value;
+    }
+
+    static bool jsonTrue(const JsonMembers& members, std::string_view key)
+    {
+        auto member = members.find(key);
+        return member != members.end() && member->second == "true";
+    }
+
+    static std::string metaJson(const std::string& bucket, const ObjectInfo& info, std::size_t chunkSize, bool deleted)
+    {
+        char mtime[32];
+        std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm utc;
+        gmtime_r(&now, &utc);
+        std::strftime(mtime, sizeof(mtime), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+        std::string json = "{\"name\":";
+        appendJsonString(json, info.name);
+        json += ",\"bucket\":";
+        appendJsonString(json, bucket);
+        json += ",\"nuid\":";
+        appendJsonString(json, info.nuid);
+        json += ",\"size\":" + std::to_string(info.size);
+        json += ",\"mtime\":\"" + std::string(mtime) + "\"";
+        json += ",\"chunks\":" + std::to_string(info.chunks);
+        if (!info.digest.empty()) {
+            json += ",\"digest\":";
+            appendJsonString(json, info.digest);
+        }
+        if (deleted) {
+            json += ",\"deleted\":true";
+        }
+        json += ",\"options\":{\"max_chunk_size\":" + std::to_string(chunkSize) + "}}";
+        return json;
+    }
+
+    // Chunks published but not acknowledged yet by one put(). Shared with the ack
+    // handlers, which may outlive a put() that failed.
+    struct ChunkWindow
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        int outstanding = 0;
+        std::optional<JetStreamException> error;
+
+        // Waits until fewer than max chunks are outstanding.
+        bool acquire(int max, int timeout)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!cond.wait_for(lock, std::chrono::milliseconds(timeout), [&] { return outstanding < max; })) {
+                return false;
+            }
+            ++outstanding;
+            return true;
+        }
+
+        // Waits until every chunk is acknowledged.
+        bool drain(int timeout)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            return cond.wait_for(lock, std::chrono::milliseconds(timeout), [&] { return outstanding == 0; });
+        }
+
+        void release(const JetStreamException* failure)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --outstanding;
+            if (failure && !error) {
+                error = *failure;
+            }
+            cond.notify_all();
+        }
+    };
+
+    static JetStreamState& stateOf(const std::shared_ptr<JetStreamState>& state)
+    {
+        if (!state) {
+            throw Exception(NATS_ILLEGAL_STATE);
+        }
+        return *state;
+    }
+
+    ObjectStore JetStream::createObjectStore(const ObjectStoreConfig& config)
+    {
+        auto& state = stateOf(m_state);
+        if (config.bucket.empty() || config.chunkSize == 0 || config.window <= 0) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        std::string name = streamName(config.bucket);
+        std::string chunks = "$O." + config.bucket + ".C.>";
+        std::string metas = "$O." + config.bucket + ".M.>";
+        const char* subjects[] = {chunks.c_str(), metas.c_str()};
+        jsStreamConfig cfg;
+        jsStreamConfig_Init(&cfg);
+        cfg.Name = name.c_str();
+        cfg.Subjects = subjects;
+        cfg.SubjectsLen = 2;
+        cfg.Storage = static_cast<jsStorageType>(config.storage);
+        cfg.MaxBytes = config.maxBytes;
+        cfg.Discard = js_DiscardNew;
+        // the metadata of an object replaces the previous one with a rollup
+        cfg.AllowRollup = true;
+        cfg.AllowDirect = true;
+        jsStreamInfo* info = nullptr;
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_AddStream(&info, state.js, &cfg, nullptr, &code);
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+        jsStreamInfo_Destroy(info);
+
+        ObjectStore store;
+        store.m_js.m_state = m_state;
+        store.m_bucket = config.bucket;
+        store.m_chunkSize = config.chunkSize;
+        store.m_window = config.window;
+        return store;
+    }
+
+    ObjectStore JetStream::objectStore(const std::string& bucket)
+    {
+        streamInfo(streamName(bucket));
+        ObjectStore store;
+        store.m_js.m_state = m_state;
+        store.m_bucket = bucket;
+        return store;
+    }
+
+    void JetStream::deleteObjectStore(const std::string& bucket)
+    {
+        deleteStream(streamName(bucket));
+    }
+
+    std::string ObjectStore::metaSubject(const std::string& name) const
+    {
+        return "$O." + m_bucket + ".M." + base64Url(name);
+    }
+
+    void ObjectStore::purgeChunks(const std::string& nuid)
+    {
+        auto& state = stateOf(m_js.m_state);
+        std::string subject = chunkSubject(m_bucket, nuid);
+        jsOptions opts;
+        jsOptions_Init(&opts);
+        opts.Stream.Purge.Subject = subject.c_str();
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_PurgeStream(state.js, streamName(m_bucket).c_str(), &opts, &code);
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+    }
+
+    // Publishes the metadata of info, replacing the previous one.
+    static void publishMeta(JetStream& js, const std::string& subject, const std::string& json)
+    {
+        natsMsg* msg = nullptr;
+        auto err = natsMsg_Create(&msg, subject.c_str(), nullptr, json.data(), static_cast<int>(json.size()));
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+        Message meta(msg);
+        err = natsMsgHeader_Set(msg, "Nats-Rollup", "sub");
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+        js.publish(meta);
+    }
+
+    ObjectInfo ObjectStore::put(const std::string& name, const ObjectReader& reader)
+    {
+        auto& state = stateOf(m_js.m_state);
+        if (name.empty()) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        auto previous = info(name);
+        ObjectInfo result;
+        result.name = name;
+        result.nuid = newNuid();
+        std::string subject = chunkSubject(m_bucket, result.nuid);
+        auto window = std::make_shared<ChunkWindow>();
+        std::vector<std::byte> buffer(m_chunkSize);
+        Sha256 sha;
+        try {
+            bool end = false;
+            while (!end) {
+                std::size_t filled = 0;
+                while (filled < buffer.size()) {
+                    std::size_t n = reader(std::span<std::byte>(buffer).subspan(filled));
+                    if (n == 0) {
+                        end = true;
+                        break;
+                    }
+                    filled += n;
+                }
+                if (filled == 0) {
+                    break;
+                }
+                sha.update(std::span<const std::byte>(buffer).first(filled));
+                if (!window->acquire(m_window, state.timeout)) {
+                    throw Exception(NATS_TIMEOUT);
+                }
+                natsMsg* msg = nullptr;
+                auto err = natsMsg_Create(&msg, subject.c_str(), nullptr, reinterpret_cast<const char*>(buffer.data()),
+                                          static_cast<int>(filled));
+                if (err != NATS_OK) {
+                    window->release(nullptr);
+                    throw Exception(err);
+                }
+                try {
+                    state.publishAsync(msg, [window](const PubAck&, const JetStreamException* error) {
+                        window->release(error);
+                    });
+                } catch (...) {
+                    window->release(nullptr);
+                    throw;
+                }
+                result.size += filled;
+                result.chunks++;
+            }
+            if (!window->drain(state.timeout)) {
+                throw Exception(NATS_TIMEOUT);
+            }
+            if (window->error) {
+                throw *window->error;
+            }
+            result.digest = digestOf(sha);
+            publishMeta(m_js, metaSubject(name), metaJson(m_bucket, result, m_chunkSize, false));
+        } catch (...) {
+            // best effort, the chunks are unreachable anyway without their metadata
+            try {
+                purgeChunks(result.nuid);
+            } catch (...) {
+            }
+            throw;
+        }
+        if (previous) {
+            purgeChunks(previous->nuid);
+        }
+        return result;
+    }
+
+    ObjectInfo ObjectStore::put(const std::string& name, std::span<const std::byte> data)
+    {
+        return put(name, [data](std::span<std::byte> buffer) mutable {
+            std::size_t n = std::min(buffer.size(), data.size());
+            std::memcpy(buffer.data(), data.data(), n);
+            data = data.subspan(n);
+            return n;
+        });
+    }
+
+    ObjectInfo ObjectStore::put(const std::string& name, std::string_view data)
+    {
+        return put(name, std::as_bytes(std::span<const char>(data.data(), data.size())));
+    }
+
+    ObjectInfo ObjectStore::putFile(const std::string& name, int fd)
+    {
+        return put(name, [fd](std::span<std::byte> buffer) {
+            ssize_t n;
+            do {
+                n = ::read(fd, buffer.data(), buffer.size());
+            } while (n < 0 && errno == EINTR);
+            if (n < 0) {
+                throw Exception(NATS_IO_ERROR);
+            }
+            return static_cast<std::size_t>(n);
+        });
+    }
+
+    std::optional<ObjectInfo> ObjectStore::info(const std::string& name)
+    {
+        auto& state = stateOf(m_js.m_state);
+        natsMsg* msg = nullptr;
+        jsErrCode code = static_cast<jsErrCode>(0);
+        auto err = js_GetLastMsg(&msg, state.js, streamName(m_bucket).c_str(), metaSubject(name).c_str(), nullptr,
+                                 &code);
+        if (err == NATS_NOT_FOUND) {
+            return std::nullopt;
+        }
+        if (err != NATS_OK) {
+            throwJetStream(err, code);
+        }
+        Message meta(msg);
+        auto members = parseJsonObject(meta.data());
+        if (jsonTrue(members, "deleted")) {
+            return std::nullopt;
+        }
+        ObjectInfo result;
+        result.name = jsonString(members, "name");
+        result.nuid = jsonString(members, "nuid");
+        result.size = jsonNumber(members, "size");
+        result.chunks = jsonNumber(members, "chunks");
+        result.digest = jsonString(members, "digest");
+        return result;
+    }
+
+    ObjectInfo ObjectStore::get(const std::string& name, const ObjectWriter& writer)
+    {
+        auto& state = stateOf(m_js.m_state);
+        auto result = info(name);
+        if (!result) {
+            throw Exception(NATS_NOT_FOUND);
+        }
+        if (result->chunks == 0) {
+            return *result;
+        }
+        // an ephemeral consumer reading the chunks in order, removed on return
+        std::string subject = chunkSubject(m_bucket, result->nuid);
+        ConsumerConfig cc;
+        cc.ackPolicy = AckPolicy::None;
+        PullConsumer consumer = m_js.pullSubscribe(subject, cc);
+        FetchOptions fo;
+        fo.batch = m_window;
+        fo.expires = state.timeout;
+        std::vector<Message> batch;
+        uint64_t received = 0;
+        Sha256 sha;
+        while (received < result->chunks) {
+            if (consumer.fetch(batch, fo) == 0) {
+                throw Exception(NATS_TIMEOUT);
+            }
+            for (auto& chunk : batch) {
+                sha.update(chunk.bytes());
+                writer(chunk.bytes());
+                received++;
+            }
+        }
+        if (!result->digest.empty() && result->digest != digestOf(sha)) {
+            throw Exception(NATS_ERR);
+        }
+        return *result;
+    }
+
+    std::string ObjectStore::get(const std::string& name)
+    {
+        std::string data;
+        get(name, [&data](std::span<const std::byte> chunk) {
+            data.append(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+        });
+        return data;
+    }
+
+    ObjectInfo ObjectStore::getFile(const std::string& name, int fd)
+    {
+        return get(name, [fd](std::span<const std::byte> chunk) {
+            while (!chunk.empty()) {
+                ssize_t n = ::write(fd, chunk.data(), chunk.size());
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw Exception(NATS_IO_ERROR);
+                }
+                chunk = chunk.subspan(static_cast<std::size_t>(n));
+            }
+        });
+    }
+
+    void ObjectStore::remove(const std::string& name)
+    {
+        auto current = info(name);
+        if (!current) {
+            throw Exception(NATS_NOT_FOUND);
+        }
+        ObjectInfo deleted;
+        deleted.name = name;
+        deleted.nuid = current->nuid;
+        publishMeta(m_js, metaSubject(name), metaJson(m_bucket, deleted, m_chunkSize, true));
+        purgeChunks(current->nuid);
+    }
+
+} // namespace CppNats
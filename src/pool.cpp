@@ -0,0 +1,218 @@
+/**
+ * @file pool.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <thread>
+#include "cppnats.hpp"
+
+
+namespace CppNats {
+
+    namespace {
+
+        // in milliseconds, see registered()
+        constexpr int SubscribeFlushTimeout = 5000;
+
+        // Publishes of the pool may leave on another connection than the SUB: wait until
+        // the server has registered it. If it fails, the subscription is dropped.
+        Subscription registered(Client& client, Subscription sub)
+        {
+            client.flush(SubscribeFlushTimeout);
+            return sub;
+        }
+
+    } // namespace
+
+    ClientPool::ClientPool(std::size_t size, Sharding sharding) : m_sharding(sharding)
+    {
+        if (size == 0) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        m_clients.reserve(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            m_clients.push_back(std::make_unique<Client>());
+        }
+    }
+
+    void ClientPool::connect(const Options& opts)
+    {
+        try {
+            for (auto& client : m_clients) {
+                client->connect(opts);
+            }
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    void ClientPool::connect(const std::string& address)
+    {
+        try {
+            for (auto& client : m_clients) {
+                client->connect(address);
+            }
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    void ClientPool::close() noexcept
+    {
+        for (auto& client : m_clients) {
+            client->close();
+        }
+    }
+
+    Client& ClientPool::client(std::string_view subject)
+    {
+        std::size_t hash;
+        if (m_sharding == Sharding::BySubject) {
+            hash = std::hash<std::string_view>()(subject);
+        } else {
+            hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+        }
+        return *m_clients[hash % m_clients.size()];
+    }
+
+    Client& ClientPool::client(const Subject& subject)
+    {
+        if (m_sharding == Sharding::BySubject) {
+            return *m_clients[subject.hash() % m_clients.size()];
+        }
+        return client(subject.str());
+    }
+
+    void ClientPool::publish(const Message& message)
+    {
+        client(message.subject()).publish(message);
+    }
+
+    void ClientPool::publish(std::string_view subject, std::string_view data)
+    {
+        client(subject).publish(subject, data);
+    }
+
+    void ClientPool::publish(std::string_view subject, std::span<const std::byte> data)
+    {
+        client(subject).publish(subject, data);
+    }
+
+    void ClientPool::publish(std::string_view subject, std::string_view data, std::string_view reply)
+    {
+        client(subject).publish(subject, data, reply);
+    }
+
+    void ClientPool::publish(std::string_view subject, std::span<const std::byte> data, std::string_view reply)
+    {
+        client(subject).publish(subject, data, reply);
+    }
+
+    void ClientPool::publish(const Subject& subject, std::string_view data)
+    {
+        client(subject).publish(subject, data);
+    }
+
+    void ClientPool::publish(const Subject& subject, std::span<const std::byte> data)
+    {
+        client(subject).publish(subject, data);
+    }
+
+    Status ClientPool::tryPublish(std::string_view subject, std::string_view data) noexcept
+    {
+        return client(subject).tryPublish(subject, data);
+    }
+
+    Status ClientPool::tryPublish(const Subject& subject, std::string_view data) noexcept
+    {
+        return client(subject).tryPublish(subject, data);
+    }
+
+    Subscription ClientPool::subscribe(const std::string& subject, const SubscribeOptions& options)
+    {
+        Client& conn = client(subject);
+        return registered(conn, conn.subscribe(subject, options));
+    }
+
+    Subscription ClientPool::subscribe(const std::string& subject, MessageHandler handler,
+                                       const SubscribeOptions& options)
+    {
+        Client& conn = client(subject);
+        return registered(conn, conn.subscribe(subject, std::move(handler), options));
+    }
+
+    Subscription ClientPool::subscribe(const Subject& subject, const SubscribeOptions& options)
+    {
+        Client& conn = client(subject);
+        return registered(conn, conn.subscribe(subject, options));
+    }
+
+    Subscription ClientPool::subscribe(const Subject& subject, MessageHandler handler, const SubscribeOptions& options)
+    {
+        Client& conn = client(subject);
+        return registered(conn, conn.subscribe(subject, std::move(handler), options));
+    }
+
+    Subscription ClientPool::queueSubscribe(const std::string& subject, const std::string& group,
+                                            const SubscribeOptions& options)
+    {
+        Client& conn = client(subject);
+        return registered(conn, conn.queueSubscribe(subject, group, options));
+    }
+
+    Subscription ClientPool::queueSubscribe(const std::string& subject, const std::string& group,
+                                            MessageHandler handler, const SubscribeOptions& options)
+    {
+        Client& conn = client(subject);
+        return registered(conn, conn.queueSubscribe(subject, group, std::move(handler), options));
+    }
+
+    Message ClientPool::request(const Message& message, int timeout)
+    {
+        return client(message.subject()).request(message, timeout);
+    }
+
+    std::future<Message> ClientPool::requestAsync(const Message& message, int timeout)
+    {
+        return client(message.subject()).requestAsync(message, timeout);
+    }
+
+    std::future<Message> ClientPool::requestAsync(std::string_view subject, std::string_view data, int timeout)
+    {
+        return client(subject).requestAsync(subject, data, timeout);
+    }
+
+    RequestAwaiter ClientPool::requestAwait(const Message& message, int timeout)
+    {
+        return client(message.subject()).requestAwait(message, timeout);
+    }
+
+    RequestAwaiter ClientPool::requestAwait(std::string_view subject, std::string_view data, int timeout)
+    {
+        return client(subject).requestAwait(subject, data, timeout);
+    }
+
+    ClientStats ClientPool::stats() const
+    {
+        ClientStats total;
+        for (auto& client : m_clients) {
+            auto stats = client->stats();
+            total.inMsgs += stats.inMsgs;
+            total.inBytes += stats.inBytes;
+            total.outMsgs += stats.outMsgs;
+            total.outBytes += stats.outBytes;
+            total.reconnects += stats.reconnects;
+        }
+        return total;
+    }
+
+} // namespace CppNats
@@ -0,0 +1,256 @@
+/**
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+#include <nats.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "cppnats.hpp"
+
+namespace CppNats {
+
+    // Bounded single-producer/single-consumer ring of natsMsg pointers.
+    // The producer is the cnats delivery thread of one subscription, the consumer
+    // is the thread reading the Subscription. Push and pop are lock-free; the mutex
+    // is only taken when one side has to sleep, and the other side only touches it
+    // when it knows somebody is sleeping.
+    // With OverflowPolicy::DropOldest the producer may also advance the read position
+    // to evict the oldest message, so the consumer then claims slots with a CAS.
+    class MessageQueue
+    {
+        public:
+            MessageQueue(std::size_t capacity, OverflowPolicy policy = OverflowPolicy::DropNewest)
+                : m_evicting(policy == OverflowPolicy::DropOldest), m_blocking(policy == OverflowPolicy::Block)
+            {
+                std::size_t size = 1;
+                while (size < capacity) {
+                    size <<= 1;
+                }
+                m_mask = size - 1;
+                m_slots = std::make_unique<std::atomic<natsMsg*>[]>(size);
+            }
+
+            ~MessageQueue()
+            {
+                while (natsMsg* msg = pop()) {
+                    natsMsg_Destroy(msg);
+                }
+            }
+
+            MessageQueue(const MessageQueue&) = delete;
+            MessageQueue& operator=(const MessageQueue&) = delete;
+
+            std::size_t capacity() const noexcept { return m_mask + 1; }
+
+            std::size_t size() const noexcept
+            {
+                auto head = m_head.load(std::memory_order_acquire);
+                auto tail = m_tail.load(std::memory_order_acquire);
+                return tail > head ? tail - head : 0;
+            }
+
+            // Largest number of messages the queue has held at once.
+            std::size_t highWater() const noexcept { return m_highWater.load(std::memory_order_relaxed); }
+
+            bool closed() const noexcept { return m_closed.load(std::memory_order_acquire); }
+
+            // Producer side. Returns false when the ring is full, the caller keeps the message.
+            bool push(natsMsg* msg) noexcept
+            {
+                auto tail = m_tail.load(std::memory_order_relaxed);
+                auto depth = tail - m_head.load(std::memory_order_acquire);
+                if (depth > m_mask) {
+                    return false;
+                }
+                store(tail, depth, msg);
+                return true;
+            }
+
+            // Producer side, DropOldest policy. Always queues msg; when the ring is full
+            // the oldest message is evicted and returned for the caller to destroy.
+            natsMsg* pushEvict(natsMsg* msg) noexcept
+            {
+                natsMsg* evicted = nullptr;
+                auto tail = m_tail.load(std::memory_order_relaxed);
+                auto head = m_head.load(std::memory_order_acquire);
+                if (tail - head > m_mask) {
+                    natsMsg* oldest = m_slots[head & m_mask].load(std::memory_order_relaxed);
+                    // if the consumer wins the race, it made room itself
+                    if (m_head.compare_exchange_strong(head, head + 1, std::memory_order_acq_rel)) {
+                        evicted = oldest;
+                    }
+                    head = m_head.load(std::memory_order_acquire);
+                }
+                store(tail, tail - head, msg);
+                return evicted;
+            }
+
+            // Producer side, Block policy. Waits until the ring has room or is closed.
+            // Returns false if it was closed.
+            bool waitForSpace()
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_producerWaiting.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_spaceCond.wait(lock, [this] { return !full() || closed(); });
+                m_producerWaiting.store(false, std::memory_order_relaxed);
+                return !closed();
+            }
+
+            // Consumer side. Returns nullptr when the ring is empty.
+            natsMsg* pop() noexcept
+            {
+                auto head = m_head.load(std::memory_order_relaxed);
+                while (true) {
+                    if (head >= m_tail.load(std::memory_order_acquire)) {
+                        return nullptr;
+                    }
+                    natsMsg* msg = m_slots[head & m_mask].load(std::memory_order_relaxed);
+                    if (release(head, 1)) {
+                        return msg;
+                    }
+                    // the producer evicted it, head now holds the new read position
+                }
+            }
+
+            // Consumer side. Hands up to max messages to sink(index, msg) and releases
+            // all consumed slots at once. Returns the number of messages taken.
+            template<typename Sink>
+            std::size_t popBulk(std::size_t max, Sink&& sink) noexcept
+            {
+                natsMsg* taken[64];
+                std::size_t total = 0;
+                while (total < max) {
+                    auto head = m_head.load(std::memory_order_relaxed);
+                    std::size_t count = 0;
+                    do {
+                        auto tail = m_tail.load(std::memory_order_acquire);
+                        auto available = tail > head ? tail - head : 0;
+                        count = std::min({available, max - total, sizeof(taken) / sizeof(taken[0])});
+                        for (std::size_t i = 0; i < count; ++i) {
+                            taken[i] = m_slots[(head + i) & m_mask].load(std::memory_order_relaxed);
+                        }
+                    } while (count > 0 && !release(head, count));
+                    if (count == 0) {
+                        break;
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        sink(total + i, taken[i]);
+                    }
+                    total += count;
+                }
+                return total;
+            }
+
+            // Called once no more messages will be pushed or read, wakes up both sides.
+            void close() noexcept
+            {
+                m_closed.store(true, std::memory_order_release);
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_cond.notify_all();
+                m_spaceCond.notify_all();
+            }
+
+            // Consumer side. Waits until a message is available, the queue is closed,
+            // or the timeout (in milliseconds) expires. Returns true if a message is available.
+            bool wait(int timeout)
+            {
+                if (!empty()) {
+                    return true;
+                }
+                // a short spin catches messages arriving back to back without a syscall
+                for (int i = 0; i < 64; ++i) {
+                    std::this_thread::yield();
+                    if (!empty()) {
+                        return true;
+                    }
+                }
+                if (timeout <= 0 || closed()) {
+                    return !empty();
+                }
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_waiting.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_cond.wait_until(lock, deadline, [this] { return !empty() || closed(); });
+                m_waiting.store(false, std::memory_order_relaxed);
+                return !empty();
+            }
+
+        private:
+            bool empty() const noexcept
+            {
+                return m_head.load(std::memory_order_acquire) >= m_tail.load(std::memory_order_acquire);
+            }
+
+            bool full() const noexcept
+            {
+                return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire) > m_mask;
+            }
+
+            void store(std::size_t tail, std::size_t depth, natsMsg* msg) noexcept
+            {
+                m_slots[tail & m_mask].store(msg, std::memory_order_relaxed);
+                m_tail.store(tail + 1, std::memory_order_release);
+                // only the producer writes the high-water mark, no read-modify-write needed
+                if (depth + 1 > m_highWater.load(std::memory_order_relaxed)) {
+                    m_highWater.store(depth + 1, std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_waiting.load(std::memory_order_relaxed)) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_cond.notify_one();
+                }
+            }
+
+            // Consumer side: publishes the new read position. On failure (evicting
+            // queues only) head is updated to the current read position.
+            bool release(std::size_t& head, std::size_t count) noexcept
+            {
+                if (m_evicting) {
+                    if (!m_head.compare_exchange_strong(head, head + count, std::memory_order_acq_rel)) {
+                        return false;
+                    }
+                } else {
+                    m_head.store(head + count, std::memory_order_release);
+                }
+                if (m_blocking) {
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (m_producerWaiting.load(std::memory_order_relaxed)) {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        m_spaceCond.notify_one();
+                    }
+                }
+                return true;
+            }
+
+            const bool m_evicting;
+            const bool m_blocking;
+            std::unique_ptr<std::atomic<natsMsg*>[]> m_slots;
+            std::size_t m_mask;
+            alignas(64) std::atomic<std::size_t> m_head{0};
+            alignas(64) std::atomic<std::size_t> m_tail{0};
+            alignas(64) std::atomic<bool> m_waiting{false};
+            std::atomic<bool> m_producerWaiting{false};
+            std::atomic<std::size_t> m_highWater{0};
+            std::atomic<bool> m_closed{false};
+            std::mutex m_mutex;
+            std::condition_variable m_cond;
+            std::condition_variable m_spaceCond;
+    };
+
+} // namespace CppNats
@@ -0,0 +1,197 @@
+/**
+ * @file request.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <charconv>
+#include <cstring>
+#include <vector>
+#include "request.hpp"
+#include "helper.hpp"
+#include "subscription.hpp"
+
+
+namespace CppNats {
+
+    RequestMux::RequestMux(natsConnection* conn, std::shared_ptr<TimerService> timer)
+        : m_conn(conn), m_timer(std::move(timer))
+    {
+        natsInbox* inbox = nullptr;
+        auto err = natsInbox_Create(&inbox);
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+        m_prefix = std::string(inbox) + ".";
+        natsInbox_Destroy(inbox);
+    }
+
+    std::shared_ptr<RequestMux> RequestMux::create(natsConnection* conn, std::shared_ptr<TimerService> timer)
+    {
+        auto mux = std::make_shared<RequestMux>(conn, std::move(timer));
+        std::weak_ptr<RequestMux> weak = mux;
+        std::string subject = mux->m_prefix + "*";
+        auto state = SubscriptionState::create(conn, subject.c_str(), std::string(), SubscribeOptions(), SubscriptionContext(),
+            [weak](Message& msg) {
+                if (auto self = weak.lock()) {
+                    self->onReply(msg);
+                }
+            });
+        mux->m_sub.m_state = std::move(state);
+        return mux;
+    }
+
+    std::string RequestMux::replySubject(uint64_t token) const
+    {
+        char digits[24];
+        auto end = std::to_chars(digits, digits + sizeof(digits), token).ptr;
+        return m_prefix + std::string(digits, end);
+    }
+
+    uint64_t RequestMux::add(int timeout, Completion completion)
+    {
+        auto token = ++m_nextToken;
+        std::weak_ptr<RequestMux> weak = weak_from_this();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto timer = m_timer->schedule(timeout, [weak, token] {
+            if (auto self = weak.lock()) {
+                self->complete(token, NATS_TIMEOUT, Message());
+            }
+        });
+        m_pending.emplace(token, Pending{std::move(completion), timer});
+        return token;
+    }
+
+    bool RequestMux::cancel(uint64_t token)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(token);
+        if (it == m_pending.end()) {
+            return false;
+        }
+        m_timer->cancel(it->second.timer);
+        m_pending.erase(it);
+        return true;
+    }
+
+    natsStatus RequestMux::send(uint64_t token, std::string_view subject, std::span<const std::byte> data)
+    {
+        auto reply = replySubject(token);
+        CString subj(subject);
+        return natsConnection_PublishRequest(m_conn, subj.c_str(), reply.c_str(),
+                                             data.data(), static_cast<int>(data.size()));
+    }
+
+    void RequestMux::request(std::string_view subject, std::span<const std::byte> data, int timeout, Completion completion)
+    {
+        auto token = add(timeout, std::move(completion));
+        auto err = send(token, subject, data);
+        if (err != NATS_OK) {
+            cancel(token);
+            throw Exception(err);
+        }
+    }
+
+    void RequestMux::complete(uint64_t token, natsStatus status, Message&& msg)
+    {
+        Completion completion;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_pending.find(token);
+            if (it == m_pending.end()) {
+                // late reply of a request that already timed out
+                return;
+            }
+            if (status != NATS_TIMEOUT) {
+                m_timer->cancel(it->second.timer);
+            }
+            completion = std::move(it->second.completion);
+            m_pending.erase(it);
+        }
+        completion(status, std::move(msg));
+    }
+
+    void RequestMux::onReply(Message& msg)
+    {
+        auto subject = msg.subject();
+        uint64_t token = 0;
+        auto digits = subject.substr(m_prefix.size());
+        if (std::from_chars(digits.data(), digits.data() + digits.size(), token).ec != std::errc()) {
+            return;
+        }
+        // the server answers with an empty "503" status message when nobody listens
+        const char* status = nullptr;
+        if (msg.data().empty()
+            && natsMsgHeader_Get(msg.getNatsMsg(), "Status", &status) == NATS_OK
+            && std::strcmp(status, "503") == 0) {
+            complete(token, NATS_NO_RESPONDERS, Message());
+            return;
+        }
+        complete(token, NATS_OK, std::move(msg));
+    }
+
+    void RequestMux::close()
+    {
+        std::unordered_map<uint64_t, Pending> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            pending.swap(m_pending);
+            for (auto& entry : pending) {
+                m_timer->cancel(entry.second.timer);
+            }
+        }
+        for (auto& entry : pending) {
+            entry.second.completion(NATS_CONNECTION_CLOSED, Message());
+        }
+        m_sub.unsubscribe();
+    }
+
+    bool ReplyAwaiter::await_suspend(std::coroutine_handle<> handle)
+    {
+        // the completion may resume (and destroy) the awaiting coroutine as soon as it is
+        // registered, so nothing below touches this object unless the completion was cancelled
+        auto mux = m_mux;
+        auto subject = m_subject;
+        auto data = m_data;
+        bool flush = m_flush;
+        auto token = mux->add(m_timeout, [this, handle](natsStatus status, Message&& reply) {
+            m_status = status;
+            m_reply = std::move(reply);
+            handle.resume();
+        });
+        natsStatus err;
+        if (flush) {
+            // the message comes back on our own inbox once the server has processed it
+            err = mux->send(token, mux->replySubject(token), std::span<const std::byte>());
+        } else {
+            err = mux->send(token, subject, data);
+        }
+        if (err != NATS_OK && mux->cancel(token)) {
+            m_status = err;
+            return false;
+        }
+        return true;
+    }
+
+    Message RequestAwaiter::await_resume()
+    {
+        if (m_status != NATS_OK) {
+            throw Exception(m_status);
+        }
+        return std::move(m_reply);
+    }
+
+    void FlushAwaiter::await_resume()
+    {
+        if (m_status != NATS_OK) {
+            throw Exception(m_status);
+        }
+    }
+
+} // namespace CppNats
@@ -0,0 +1,76 @@
+/**
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "cppnats.hpp"
+#include "timer.hpp"
+
+namespace CppNats {
+
+    // Routes the replies of all asynchronous requests of a client through a single
+    // wildcard subscription on <inbox>.*: each request gets a numeric token appended
+    // to the inbox, and the reply is matched back to its completion by that token.
+    class RequestMux : public std::enable_shared_from_this<RequestMux>
+    {
+        public:
+            // Called exactly once, with NATS_OK and the reply, or with the failure
+            // (NATS_TIMEOUT, NATS_NO_RESPONDERS, NATS_CONNECTION_CLOSED) and an empty message.
+            using Completion = std::function<void(natsStatus, Message&&)>;
+
+            static std::shared_ptr<RequestMux> create(natsConnection* conn, std::shared_ptr<TimerService> timer);
+
+            RequestMux(natsConnection* conn, std::shared_ptr<TimerService> timer);
+            RequestMux(const RequestMux&) = delete;
+            RequestMux& operator=(const RequestMux&) = delete;
+
+            // Registers a completion and returns its token; the reply subject to
+            // publish with is replySubject(token).
+            uint64_t add(int timeout, Completion completion);
+            // Removes a completion that has not run yet. Returns false if it already ran or is running.
+            bool cancel(uint64_t token);
+            std::string replySubject(uint64_t token) const;
+
+            // Publishes data to subject with the reply subject of token.
+            natsStatus send(uint64_t token, std::string_view subject, std::span<const std::byte> data);
+
+            // Publishes a request and registers its completion. Throws if the
+            // publish fails, in which case the completion is never called.
+            void request(std::string_view subject, std::span<const std::byte> data, int timeout, Completion completion);
+
+            // Fails every pending completion with NATS_CONNECTION_CLOSED.
+            void close();
+
+        private:
+            struct Pending
+            {
+                Completion completion;
+                TimerService::TimerId timer;
+            };
+
+            void onReply(Message& msg);
+            void complete(uint64_t token, natsStatus status, Message&& msg);
+
+            natsConnection* m_conn;
+            std::shared_ptr<TimerService> m_timer;
+            std::string m_prefix;
+            Subscription m_sub;
+            std::atomic<uint64_t> m_nextToken{0};
+            std::mutex m_mutex;
+            std::unordered_map<uint64_t, Pending> m_pending;
+    };
+
+} // namespace CppNats
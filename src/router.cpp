@@ -0,0 +1,265 @@
+/**
+ * @file router.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cppnats.hpp"
+
+
+namespace CppNats {
+
+    namespace {
+
+        struct RouteEntry
+        {
+            uint64_t id;
+            std::shared_ptr<const RouteHandler> handler;
+        };
+
+        // One token level of the trie. Nodes are immutable once published: a change
+        // copies the nodes on the path of its pattern and shares all the others.
+        struct RouteNode
+        {
+            std::unordered_map<std::string, std::shared_ptr<const RouteNode>, KeyHash, std::equal_to<>> children;
+            std::shared_ptr<const RouteNode> star;
+            // routes whose pattern ends at this node
+            std::vector<RouteEntry> handlers;
+            // routes whose pattern ends with '>' after this node
+            std::vector<RouteEntry> tail;
+
+            bool empty() const noexcept
+            {
+                return children.empty() && !star && handlers.empty() && tail.empty();
+            }
+        };
+
+        using NodePtr = std::shared_ptr<const RouteNode>;
+
+        std::vector<std::string_view> tokenize(std::string_view subject)
+        {
+            std::vector<std::string_view> tokens;
+            std::size_t start = 0;
+            while (true) {
+                auto end = subject.find('.', start);
+                tokens.push_back(subject.substr(start, end == std::string_view::npos ? end : end - start));
+                if (end == std::string_view::npos) {
+                    return tokens;
+                }
+                start = end + 1;
+            }
+        }
+
+        NodePtr insert(const RouteNode* node, std::span<const std::string_view> tokens, const RouteEntry& entry)
+        {
+            auto copy = node ? std::make_shared<RouteNode>(*node) : std::make_shared<RouteNode>();
+            if (tokens.empty()) {
+                copy->handlers.push_back(entry);
+            } else if (tokens.front() == ">") {
+                copy->tail.push_back(entry);
+            } else if (tokens.front() == "*") {
+                copy->star = insert(copy->star.get(), tokens.subspan(1), entry);
+            } else {
+                auto& child = copy->children[std::string(tokens.front())];
+                child = insert(child.get(), tokens.subspan(1), entry);
+            }
+            return copy;
+        }
+
+        void eraseEntry(std::vector<RouteEntry>& entries, uint64_t id)
+        {
+            std::erase_if(entries, [id](const RouteEntry& entry) { return entry.id == id; });
+        }
+
+        // Returns null when the node is left empty, so that its parent drops it.
+        NodePtr erase(const RouteNode& node, std::span<const std::string_view> tokens, uint64_t id)
+        {
+            auto copy = std::make_shared<RouteNode>(node);
+            if (tokens.empty()) {
+                eraseEntry(copy->handlers, id);
+            } else if (tokens.front() == ">") {
+                eraseEntry(copy->tail, id);
+            } else if (tokens.front() == "*") {
+                if (copy->star) {
+                    copy->star = erase(*copy->star, tokens.subspan(1), id);
+                }
+            } else {
+                auto child = copy->children.find(tokens.front());
+                if (child != copy->children.end()) {
+                    if (auto updated = erase(*child->second, tokens.subspan(1), id)) {
+                        child->second = std::move(updated);
+                    } else {
+                        copy->children.erase(child);
+                    }
+                }
+            }
+            return copy->empty() ? nullptr : copy;
+        }
+
+        void invoke(const std::vector<RouteEntry>& entries, const Message& message)
+        {
+            for (const auto& entry : entries) {
+                try {
+                    (*entry.handler)(message);
+                } catch (...) {
+                    // one failing route must not deprive the others of the message
+                }
+            }
+        }
+
+        // rest holds the tokens not matched yet, end is set once they are all matched.
+        std::size_t dispatch(const RouteNode& node, std::string_view rest, bool end, const Message& message)
+        {
+            if (end) {
+                invoke(node.handlers, message);
+                return node.handlers.size();
+            }
+            invoke(node.tail, message);
+            std::size_t matched = node.tail.size();
+            auto dot = rest.find('.');
+            auto token = rest.substr(0, dot);
+            auto next = dot == std::string_view::npos ? std::string_view() : rest.substr(dot + 1);
+            bool last = dot == std::string_view::npos;
+            auto child = node.children.find(token);
+            if (child != node.children.end()) {
+                matched += dispatch(*child->second, next, last, message);
+            }
+            if (node.star) {
+                matched += dispatch(*node.star, next, last, message);
+            }
+            return matched;
+        }
+
+    } // namespace
+
+    // Shared by the Router, its Routes and the handlers of its root subscriptions.
+    class RouteTable
+    {
+    public:
+        // Not lock-free on libstdc++: load() and store() briefly serialize on the pointer
+        // itself, but a change is built entirely before its store().
+        std::atomic<NodePtr> root;
+        std::atomic<uint64_t> unrouted{0};
+
+        uint64_t add(const Subject& pattern, RouteHandler handler)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            RouteEntry entry{++m_lastId, std::make_shared<const RouteHandler>(std::move(handler))};
+            auto tokens = tokenize(pattern.str());
+            root.store(insert(root.load().get(), tokens, entry));
+            m_patterns.emplace(entry.id, pattern);
+            return entry.id;
+        }
+
+        void remove(uint64_t id)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto pattern = m_patterns.find(id);
+            if (pattern == m_patterns.end()) {
+                return;
+            }
+            auto tokens = tokenize(pattern->second.str());
+            if (auto current = root.load()) {
+                root.store(erase(*current, tokens, id));
+            }
+            m_patterns.erase(pattern);
+        }
+
+        void dispatch(const Message& message)
+        {
+            auto current = root.load();
+            if (!current || CppNats::dispatch(*current, message.subject(), false, message) == 0) {
+                unrouted.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        // serializes changes, dispatch only loads root
+        std::mutex m_mutex;
+        uint64_t m_lastId = 0;
+        std::unordered_map<uint64_t, Subject> m_patterns;
+    };
+
+    Route::~Route() noexcept
+    {
+        remove();
+    }
+
+    Route::Route(Route&& other) noexcept : m_table(std::move(other.m_table)), m_id(other.m_id)
+    {
+        other.m_id = 0;
+    }
+
+    Route& Route::operator=(Route&& other) noexcept
+    {
+        if (this != &other) {
+            remove();
+            m_table = std::move(other.m_table);
+            m_id = other.m_id;
+            other.m_id = 0;
+        }
+        return *this;
+    }
+
+    void Route::remove() noexcept
+    {
+        if (auto table = m_table.lock()) {
+            try {
+                table->remove(m_id);
+            } catch (...) {
+                // only allocation can fail, the route then stays in the trie
+            }
+        }
+        m_table.reset();
+        m_id = 0;
+    }
+
+    Router::Router(Client& client) : m_client(client), m_table(std::make_shared<RouteTable>()) {}
+
+    Router::~Router() noexcept
+    {
+        close();
+    }
+
+    void Router::listen(const std::string& subject, const SubscribeOptions& options)
+    {
+        // the handler keeps the table alive, not the Router
+        m_subscriptions.push_back(m_client.subscribe(subject, [table = m_table](Message& message) {
+            table->dispatch(message);
+        }, options));
+    }
+
+    Route Router::route(std::string_view pattern, RouteHandler handler)
+    {
+        if (!handler) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        Subject subject(pattern);
+        Route route;
+        route.m_id = m_table->add(subject, std::move(handler));
+        route.m_table = m_table;
+        return route;
+    }
+
+    void Router::close() noexcept
+    {
+        m_subscriptions.clear();
+    }
+
+    uint64_t Router::unrouted() const noexcept
+    {
+        return m_table->unrouted.load(std::memory_order_relaxed);
+    }
+
+} // namespace CppNats
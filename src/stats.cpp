@@ -0,0 +1,183 @@
+/**
+ * @file stats.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <algorithm>
+#include <span>
+#include <string>
+#include <vector>
+#include "cppnats.hpp"
+#include "subscription.hpp"
+
+
+namespace CppNats {
+
+    // Appends the TYPE line of a metric family.
+    static void family(std::string& out, std::string_view prefix, const char* name, const char* type)
+    {
+        out.append("# TYPE ").append(prefix).append("_").append(name).append(" ").append(type).append("\n");
+    }
+
+    // Appends a metric without labels, preceded by its TYPE line.
+    template<typename T>
+    static void metric(std::string& out, std::string_view prefix, const char* name, const char* type, T value)
+    {
+        family(out, prefix, name, type);
+        out.append(prefix).append("_").append(name).append(" ").append(std::to_string(value)).append("\n");
+    }
+
+    // Label values escape backslash, double quote and line feed.
+    static std::string subjectLabel(std::string_view subject)
+    {
+        std::string label = "subject=\"";
+        for (char c : subject) {
+            if (c == '\\' || c == '"') {
+                label += '\\';
+                label += c;
+            } else if (c == '\n') {
+                label += "\\n";
+            } else {
+                label += c;
+            }
+        }
+        label += '"';
+        return label;
+    }
+
+    std::string ClientStats::toPrometheus(std::string_view prefix) const
+    {
+        std::string out;
+        metric(out, prefix, "in_msgs_total", "counter", inMsgs);
+        metric(out, prefix, "in_bytes_total", "counter", inBytes);
+        metric(out, prefix, "out_msgs_total", "counter", outMsgs);
+        metric(out, prefix, "out_bytes_total", "counter", outBytes);
+        metric(out, prefix, "reconnects_total", "counter", reconnects);
+        return out;
+    }
+
+    std::string SubscriptionStats::toPrometheus(std::string_view prefix) const
+    {
+        return CppNats::toPrometheus(std::span<const SubscriptionStats>(this, 1), prefix);
+    }
+
+    std::string toPrometheus(std::span<const SubscriptionStats> stats, std::string_view prefix)
+    {
+        struct Family
+        {
+            const char* name;
+            const char* type;
+            std::string (*value)(const SubscriptionStats&);
+        };
+        static constexpr Family families[] = {
+            {"subscription_pending_msgs", "gauge", [](const SubscriptionStats& s) { return std::to_string(s.pendingMsgs); }},
+            {"subscription_pending_bytes", "gauge", [](const SubscriptionStats& s) { return std::to_string(s.pendingBytes); }},
+            {"subscription_max_pending_msgs", "gauge", [](const SubscriptionStats& s) { return std::to_string(s.maxPendingMsgs); }},
+            {"subscription_max_pending_bytes", "gauge", [](const SubscriptionStats& s) { return std::to_string(s.maxPendingBytes); }},
+            {"subscription_delivered_total", "counter", [](const SubscriptionStats& s) { return std::to_string(s.delivered); }},
+            {"subscription_dropped_total", "counter", [](const SubscriptionStats& s) { return std::to_string(s.droppedMsgs); }},
+            {"subscription_queue_depth", "gauge", [](const SubscriptionStats& s) { return std::to_string(s.queueDepth); }},
+            {"subscription_queue_high_water", "gauge", [](const SubscriptionStats& s) { return std::to_string(s.queueHighWater); }},
+            {"subscription_queue_capacity", "gauge", [](const SubscriptionStats& s) { return std::to_string(s.queueCapacity); }},
+            {"subscription_queue_dropped_total", "counter", [](const SubscriptionStats& s) { return std::to_string(s.queueDropped); }},
+        };
+
+        std::vector<std::string> labels;
+        labels.reserve(stats.size());
+        for (const auto& subscription : stats) {
+            labels.push_back(subjectLabel(subscription.subject));
+        }
+
+        std::string out;
+        for (const auto& metricFamily : families) {
+            family(out, prefix, metricFamily.name, metricFamily.type);
+            for (std::size_t i = 0; i < stats.size(); ++i) {
+                out.append(prefix).append("_").append(metricFamily.name);
+                out.append("{").append(labels[i]).append("} ").append(metricFamily.value(stats[i])).append("\n");
+            }
+        }
+        return out;
+    }
+
+    ClientStats Client::stats() const
+    {
+        natsStatistics* natsStats = nullptr;
+        auto err = natsStatistics_Create(&natsStats);
+        if (err == NATS_OK) {
+            err = natsConnection_GetStats(m_conn, natsStats);
+        }
+        ClientStats stats;
+        if (err == NATS_OK) {
+            err = natsStatistics_GetCounts(natsStats, &stats.inMsgs, &stats.inBytes,
+                                           &stats.outMsgs, &stats.outBytes, &stats.reconnects);
+        }
+        natsStatistics_Destroy(natsStats);
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+        return stats;
+    }
+
+    ConnectionStatus Client::status() const
+    {
+        if (!m_conn) {
+            return ConnectionStatus::Disconnected;
+        }
+        return static_cast<ConnectionStatus>(natsConnection_Status(m_conn));
+    }
+
+    std::size_t Client::buffered() const
+    {
+        // cnats returns -1 once the connection is closed
+        int bytes = m_conn ? natsConnection_Buffered(m_conn) : 0;
+        return bytes > 0 ? static_cast<std::size_t>(bytes) : 0;
+    }
+
+    SubscriptionStats Subscription::stats() const
+    {
+        if (!m_state) {
+            throw Exception(NATS_INVALID_SUBSCRIPTION);
+        }
+        return m_state->stats();
+    }
+
+    SubscriptionStats SubscriptionState::stats() const
+    {
+        SubscriptionStats stats;
+        stats.subject = subject;
+        int pendingMsgs = 0;
+        int pendingBytes = 0;
+        int maxPendingMsgs = 0;
+        int maxPendingBytes = 0;
+        // fails once the subscription is closed, only the queue counters are left then
+        if (natsSubscription_GetStats(sub, &pendingMsgs, &pendingBytes, &maxPendingMsgs, &maxPendingBytes,
+                                      &stats.delivered, &stats.droppedMsgs) == NATS_OK) {
+            stats.pendingMsgs = pendingMsgs;
+            stats.pendingBytes = pendingBytes;
+            stats.maxPendingMsgs = maxPendingMsgs;
+            stats.maxPendingBytes = maxPendingBytes;
+        }
+        if (queue) {
+            stats.queueDepth = queue->size();
+            stats.queueHighWater = queue->highWater();
+            stats.queueCapacity = queue->capacity();
+        }
+        if (workers) {
+            for (auto& workerQueue : workers->queues()) {
+                stats.queueDepth += workerQueue->size();
+                stats.queueHighWater = std::max<uint64_t>(stats.queueHighWater, workerQueue->highWater());
+                stats.queueCapacity += workerQueue->capacity();
+            }
+        }
+        stats.queueDropped = dropped.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+} // namespace CppNats
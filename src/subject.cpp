@@ -0,0 +1,79 @@
+/**
+ * @file subject.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include "cppnats.hpp"
+
+
+namespace CppNats {
+
+    namespace {
+
+        // Returns whether subject holds a wildcard, throws if it is invalid.
+        bool validate(std::string_view subject)
+        {
+            bool wildcard = false;
+            std::size_t start = 0;
+            while (true) {
+                auto end = subject.find('.', start);
+                auto token = subject.substr(start, end == std::string_view::npos ? end : end - start);
+                if (token.empty()) {
+                    throw Exception(NATS_INVALID_SUBJECT);
+                }
+                for (char c : token) {
+                    if (static_cast<unsigned char>(c) <= ' ' || c == 0x7f) {
+                        throw Exception(NATS_INVALID_SUBJECT);
+                    }
+                    if ((c == '*' || c == '>') && token.size() > 1) {
+                        throw Exception(NATS_INVALID_SUBJECT);
+                    }
+                }
+                if (token == "*" || token == ">") {
+                    wildcard = true;
+                }
+                if (end == std::string_view::npos) {
+                    return wildcard;
+                }
+                if (token == ">") {
+                    throw Exception(NATS_INVALID_SUBJECT);
+                }
+                start = end + 1;
+            }
+        }
+
+        // Interned subjects are never released: the set only holds the subjects an
+        // application chose to build Subjects for. Nodes never move, neither do the strings.
+        const std::string& intern(std::string_view subject)
+        {
+            static std::mutex mutex;
+            static std::unordered_set<std::string, KeyHash, std::equal_to<>> subjects;
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = subjects.find(subject);
+            if (found == subjects.end()) {
+                found = subjects.emplace(subject).first;
+            }
+            return *found;
+        }
+
+    } // namespace
+
+    Subject::Subject(std::string_view subject) : m_wildcard(validate(subject))
+    {
+        const std::string& interned = intern(subject);
+        m_str = interned.c_str();
+        m_size = interned.size();
+        m_hash = std::hash<std::string_view>()(interned);
+    }
+
+} // namespace CppNats
@@ -0,0 +1,383 @@
+/**
+ * @file subscription.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include "cppnats.hpp"
+#include "subscription.hpp"
+#include "events.hpp"
+
+
+namespace CppNats {
+
+    SubscriptionState::SubscriptionState(const SubscribeOptions& options, MessageHandler handler)
+        : handler(std::move(handler)), overflow(options.overflow), onSlowConsumer(options.onSlowConsumer)
+    {
+        if (!this->handler) {
+            queue.emplace(options.capacity, options.overflow);
+        } else if (options.workers > 0) {
+            workers.emplace(options.workers, options.capacity, options.overflow, options.dispatch);
+        }
+    }
+
+    SubscriptionState::~SubscriptionState()
+    {
+        if (events) {
+            events->untrack(sub);
+        }
+        natsSubscription_Destroy(sub);
+    }
+
+    // Applies the pending limits of options, keeping the cnats default for the unset ones.
+    static natsStatus setPendingLimits(natsSubscription* sub, const SubscribeOptions& options)
+    {
+        if (options.maxPendingMsgs == 0 && options.maxPendingBytes == 0) {
+            return NATS_OK;
+        }
+        int msgs = 0;
+        int bytes = 0;
+        auto err = natsSubscription_GetPendingLimits(sub, &msgs, &bytes);
+        if (err != NATS_OK) {
+            return err;
+        }
+        if (options.maxPendingMsgs != 0) {
+            msgs = options.maxPendingMsgs;
+        }
+        if (options.maxPendingBytes != 0) {
+            bytes = options.maxPendingBytes;
+        }
+        return natsSubscription_SetPendingLimits(sub, msgs, bytes);
+    }
+
+    std::shared_ptr<SubscriptionState> SubscriptionState::create(natsConnection* conn, const char* subject,
+                                                                 const std::string& queueGroup,
+                                                                 const SubscribeOptions& options,
+                                                                 const SubscriptionContext& context,
+                                                                 MessageHandler handler)
+    {
+        if (options.capacity == 0 || (options.workers > 0 && !handler)) {
+            throw Exception(NATS_INVALID_ARG);
+        }
+        auto state = std::make_shared<SubscriptionState>(options, std::move(handler));
+        state->timer = context.timer;
+        state->subject = subject;
+        if (context.payloadPool) {
+            state->payloadPool.emplace(*context.payloadPool);
+        }
+        auto callback = state->handler ? onHandlerMessage : onMessage;
+        natsStatus err;
+        if (queueGroup.empty()) {
+            err = natsConnection_Subscribe(&state->sub, conn, subject, callback, state.get());
+        } else {
+            err = natsConnection_QueueSubscribe(&state->sub, conn, subject, queueGroup.c_str(), callback,
+                                                state.get());
+        }
+        if (err != NATS_OK) {
+            throw Exception(err);
+        }
+        // Messages may already be delivered to the callback: the delivery ref makes
+        // teardown wait for it before anything else can fail. It is released by
+        // onComplete, once cnats is done with the callbacks.
+        auto deliveryRef = new std::shared_ptr<SubscriptionState>(state);
+        err = natsSubscription_SetOnCompleteCB(state->sub, onComplete, deliveryRef);
+        if (err != NATS_OK) {
+            // only fails on a subscription already closed. Nothing would tell when its
+            // callbacks are over, so the delivery ref is left to them rather than freed.
+            natsSubscription_Unsubscribe(state->sub);
+            throw Exception(err);
+        }
+        if (state->workers) {
+            // onComplete joins the workers before releasing the state
+            auto raw = state.get();
+            try {
+                state->workers->start([raw](natsMsg* msg) { raw->deliver(msg); });
+            } catch (...) {
+                state->unsubscribe();
+                throw;
+            }
+        }
+        err = setPendingLimits(state->sub, options);
+        if (err != NATS_OK) {
+            // the usual teardown, the state lives on until onComplete
+            state->unsubscribe();
+            throw Exception(err);
+        }
+        if (state->onSlowConsumer && context.events) {
+            state->events = context.events;
+            state->events->track(state->sub, state);
+        }
+        return state;
+    }
+
+    void SubscriptionState::reportSlowConsumer()
+    {
+        if (!onSlowConsumer) {
+            return;
+        }
+        try {
+            onSlowConsumer(stats());
+        } catch (...) {
+            // must not unwind through cnats
+        }
+    }
+
+    void SubscriptionState::drop(natsMsg* msg)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        natsMsg_Destroy(msg);
+        if (!slow.exchange(true, std::memory_order_relaxed)) {
+            reportSlowConsumer();
+        }
+    }
+
+    bool SubscriptionState::enqueue(MessageQueue& target, natsMsg* msg)
+    {
+        switch (overflow) {
+            case OverflowPolicy::DropNewest:
+                if (!target.push(msg)) {
+                    drop(msg);
+                    return false;
+                }
+                break;
+            case OverflowPolicy::DropOldest:
+                if (natsMsg* evicted = target.pushEvict(msg)) {
+                    drop(evicted);
+                    return true;
+                }
+                break;
+            case OverflowPolicy::Block:
+                while (!target.push(msg)) {
+                    if (!slow.exchange(true, std::memory_order_relaxed)) {
+                        reportSlowConsumer();
+                    }
+                    if (!target.waitForSpace()) {
+                        // unsubscribed while waiting
+                        dropped.fetch_add(1, std::memory_order_relaxed);
+                        natsMsg_Destroy(msg);
+                        return false;
+                    }
+                }
+                break;
+        }
+        if (slow.load(std::memory_order_relaxed)) {
+            slow.store(false, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    void SubscriptionState::onMessage(natsConnection*, natsSubscription*, natsMsg* msg, void* closure)
+    {
+        auto state = static_cast<SubscriptionState*>(closure);
+        if (!state->enqueue(*state->queue, msg)) {
+            return;
+        }
+        // the queue fenced the new tail before this load, see suspend()
+        if (state->awaiting.load(std::memory_order_relaxed)) {
+            state->resumeAwaiter(NATS_OK);
+        }
+    }
+
+    void SubscriptionState::deliver(natsMsg* msg)
+    {
+        Message message(msg);
+        try {
+            handler(message);
+        } catch (...) {
+            // there is nobody to report to on the delivery thread or a worker, and
+            // an exception must not unwind through cnats
+        }
+    }
+
+    void SubscriptionState::onHandlerMessage(natsConnection*, natsSubscription*, natsMsg* msg, void* closure)
+    {
+        auto state = static_cast<SubscriptionState*>(closure);
+        if (state->workers) {
+            state->enqueue(state->workers->queueFor(msg), msg);
+        } else {
+            state->deliver(msg);
+        }
+    }
+
+    void SubscriptionState::onComplete(void* closure)
+    {
+        auto deliveryRef = static_cast<std::shared_ptr<SubscriptionState>*>(closure);
+        if ((*deliveryRef)->queue) {
+            (*deliveryRef)->queue->close();
+            (*deliveryRef)->resumeAwaiter(NATS_INVALID_SUBSCRIPTION);
+        }
+        if ((*deliveryRef)->workers) {
+            // lets the workers deliver what is already queued
+            (*deliveryRef)->workers->close();
+            (*deliveryRef)->workers->join();
+        }
+        delete deliveryRef;
+    }
+
+    bool SubscriptionState::suspend(std::coroutine_handle<> handle, natsStatus& status, int timeout)
+    {
+        std::lock_guard<std::mutex> lock(awaitMutex);
+        awaiting.store(true, std::memory_order_relaxed);
+        // pairs with the fence in MessageQueue::push(): either the producer sees
+        // awaiting, or we see its message
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue->size() > 0 || queue->closed() || timeout <= 0 || !timer) {
+            awaiting.store(false, std::memory_order_relaxed);
+            if (queue->size() > 0) {
+                status = NATS_OK;
+            } else {
+                status = queue->closed() ? NATS_INVALID_SUBSCRIPTION : NATS_TIMEOUT;
+            }
+            return false;
+        }
+        awaitHandle = handle;
+        awaitStatus = &status;
+        auto generation = ++awaitGeneration;
+        std::weak_ptr<SubscriptionState> weak = weak_from_this();
+        awaitTimer = timer->schedule(timeout, [weak, generation] {
+            if (auto self = weak.lock()) {
+                self->resumeAwaiter(NATS_TIMEOUT, generation);
+            }
+        });
+        return true;
+    }
+
+    void SubscriptionState::resumeAwaiter(natsStatus status, uint64_t generation)
+    {
+        std::coroutine_handle<> handle;
+        {
+            std::lock_guard<std::mutex> lock(awaitMutex);
+            if (!awaitHandle || (generation != 0 && generation != awaitGeneration)) {
+                return;
+            }
+            handle = awaitHandle;
+            awaitHandle = nullptr;
+            *awaitStatus = status;
+            awaiting.store(false, std::memory_order_relaxed);
+            if (status != NATS_TIMEOUT) {
+                timer->cancel(awaitTimer);
+            }
+        }
+        handle.resume();
+    }
+
+    Subscription::Subscription() = default;
+    Subscription::Subscription(Subscription&&) noexcept = default;
+
+    Subscription& Subscription::operator=(Subscription&& other) noexcept
+    {
+        if (this != &other) {
+            unsubscribe();
+            m_state = std::move(other.m_state);
+        }
+        return *this;
+    }
+
+    Subscription::~Subscription() noexcept
+    {
+        unsubscribe();
+    }
+
+    void SubscriptionState::unsubscribe() noexcept
+    {
+        // releases a delivery thread blocked on a full queue (OverflowPolicy::Block)
+        if (queue) {
+            queue->close();
+        }
+        if (workers) {
+            workers->close();
+        }
+        natsSubscription_Unsubscribe(sub);
+    }
+
+    void Subscription::unsubscribe() noexcept
+    {
+        if (m_state) {
+            m_state->unsubscribe();
+            m_state.reset();
+        }
+    }
+
+    // Queue of a subscription consumed through nextMessage()/nextBatch()
+    static MessageQueue& pullQueue(const std::shared_ptr<SubscriptionState>& state)
+    {
+        if (!state) {
+            throw Exception(NATS_INVALID_SUBSCRIPTION);
+        }
+        if (!state->queue) {
+            // messages are dispatched to the handler
+            throw Exception(NATS_ILLEGAL_STATE);
+        }
+        return *state->queue;
+    }
+
+    Message Subscription::nextMessage(const int timeout)
+    {
+        auto& queue = pullQueue(m_state);
+        if (!queue.wait(timeout)) {
+            throw Exception(queue.closed() ? NATS_INVALID_SUBSCRIPTION : NATS_TIMEOUT);
+        }
+        return Message(queue.pop());
+    }
+
+    std::size_t Subscription::nextBatch(std::span<Message> out, const int timeout)
+    {
+        auto& queue = pullQueue(m_state);
+        if (out.empty()) {
+            return 0;
+        }
+        if (!queue.wait(timeout)) {
+            if (queue.closed()) {
+                throw Exception(NATS_INVALID_SUBSCRIPTION);
+            }
+            return 0;
+        }
+        return queue.popBulk(out.size(), [&out](std::size_t i, natsMsg* msg) {
+            out[i] = Message(msg);
+        });
+    }
+
+    MessageAwaiter Subscription::nextAwait(const int timeout)
+    {
+        pullQueue(m_state);
+        return MessageAwaiter(m_state, timeout);
+    }
+
+    bool MessageAwaiter::await_suspend(std::coroutine_handle<> handle)
+    {
+        return m_state->suspend(handle, m_status, m_timeout);
+    }
+
+    Message MessageAwaiter::await_resume()
+    {
+        if (m_status != NATS_OK) {
+            throw Exception(m_status);
+        }
+        natsMsg* msg = m_state->queue->pop();
+        if (!msg) {
+            // another consumer took it, the subscription is not meant to be shared
+            throw Exception(NATS_ILLEGAL_STATE);
+        }
+        return Message(msg);
+    }
+
+    std::pmr::memory_resource* Subscription::payloadPool() const noexcept
+    {
+        if (m_state && m_state->payloadPool) {
+            return &*m_state->payloadPool;
+        }
+        return std::pmr::get_default_resource();
+    }
+
+    uint64_t Subscription::dropped() const noexcept
+    {
+        return m_state ? m_state->dropped.load(std::memory_order_relaxed) : 0;
+    }
+
+} // namespace CppNats
@@ -0,0 +1,111 @@
+/**
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <mutex>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include "cppnats.hpp"
+#include "queue.hpp"
+#include "workers.hpp"
+#include "timer.hpp"
+
+namespace CppNats {
+
+    class ConnectionEvents;
+
+    // What a subscription borrows from its client.
+    struct SubscriptionContext
+    {
+        // for nextAwait() timeouts
+        std::shared_ptr<TimerService> timer;
+        // see Options::setPayloadPool(), may be null
+        const std::pmr::pool_options* payloadPool = nullptr;
+        // for slow consumer errors reported by cnats
+        std::shared_ptr<ConnectionEvents> events;
+    };
+
+    // Shared between the Subscription handle and the cnats delivery thread.
+    // The delivery thread keeps its own reference until cnats reports that the
+    // last callback has returned, so the state always outlives the callbacks.
+    class SubscriptionState : public std::enable_shared_from_this<SubscriptionState>
+    {
+        public:
+            // Without a handler, messages are queued for nextMessage()/nextBatch().
+            SubscriptionState(const SubscribeOptions& options, MessageHandler handler);
+            ~SubscriptionState();
+
+            SubscriptionState(const SubscriptionState&) = delete;
+            SubscriptionState& operator=(const SubscriptionState&) = delete;
+
+            // Creates the cnats subscription and hands a reference to the delivery thread.
+            // An empty queueGroup makes a plain subscription.
+            static std::shared_ptr<SubscriptionState> create(natsConnection* conn, const char* subject,
+                                                             const std::string& queueGroup,
+                                                             const SubscribeOptions& options,
+                                                             const SubscriptionContext& context,
+                                                             MessageHandler handler = nullptr);
+
+            SubscriptionStats stats() const;
+            // Invokes the slow consumer handler (on the calling cnats thread).
+            void reportSlowConsumer();
+            // Stops delivery and unsubscribes. The delivery ref keeps the state alive
+            // until onComplete.
+            void unsubscribe() noexcept;
+
+            // Registers a coroutine waiting for the next message. Returns false, with
+            // status set, when the coroutine must not suspend.
+            bool suspend(std::coroutine_handle<> handle, natsStatus& status, int timeout);
+            // Resumes the waiting coroutine, if any. A non-zero generation only
+            // resumes the wait it was registered for (timeouts).
+            void resumeAwaiter(natsStatus status, uint64_t generation = 0);
+
+            natsSubscription* sub = nullptr;
+            std::string subject;
+            // empty in handler mode
+            std::optional<MessageQueue> queue;
+            MessageHandler handler;
+            // handler mode with SubscribeOptions::workers
+            std::optional<WorkerPool> workers;
+            std::shared_ptr<TimerService> timer;
+            std::shared_ptr<ConnectionEvents> events;
+            OverflowPolicy overflow;
+            SlowConsumerHandler onSlowConsumer;
+            // set while messages are being lost, so the handler runs once per episode
+            std::atomic<bool> slow{false};
+            std::atomic<uint64_t> dropped{0};
+            // see Options::setPayloadPool()
+            std::optional<std::pmr::unsynchronized_pool_resource> payloadPool;
+
+            // coroutine suspended in nextAwait(), guarded by awaitMutex
+            std::atomic<bool> awaiting{false};
+            std::mutex awaitMutex;
+            std::coroutine_handle<> awaitHandle;
+            natsStatus* awaitStatus = nullptr;
+            uint64_t awaitGeneration = 0;
+            TimerService::TimerId awaitTimer;
+
+        private:
+            // Applies the overflow policy, returns false if msg could not be queued.
+            bool enqueue(MessageQueue& target, natsMsg* msg);
+            void drop(natsMsg* msg);
+            // Runs the handler, on the delivery thread or a worker.
+            void deliver(natsMsg* msg);
+
+            static void onMessage(natsConnection* nc, natsSubscription* sub, natsMsg* msg, void* closure);
+            static void onHandlerMessage(natsConnection* nc, natsSubscription* sub, natsMsg* msg, void* closure);
+            static void onComplete(void* closure);
+    };
+
+} // namespace CppNats
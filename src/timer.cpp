@@ -0,0 +1,91 @@
+/**
+ * @file timer.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include "timer.hpp"
+
+
+namespace CppNats {
+
+    TimerService::TimerService() : m_shared(std::make_shared<Shared>()) {}
+
+    TimerService::~TimerService()
+    {
+        std::map<TimerId, std::function<void()>> dropped;
+        {
+            std::lock_guard<std::mutex> lock(m_shared->mutex);
+            m_shared->stop = true;
+            dropped.swap(m_shared->timers);
+            m_shared->cond.notify_one();
+        }
+        if (m_thread.joinable()) {
+            if (m_thread.get_id() == std::this_thread::get_id()) {
+                m_thread.detach();
+            } else {
+                m_thread.join();
+            }
+        }
+    }
+
+    TimerService::TimerId TimerService::schedule(int timeout, std::function<void()> fn)
+    {
+        std::lock_guard<std::mutex> lock(m_shared->mutex);
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(run, m_shared);
+        }
+        TimerId id(Clock::now() + std::chrono::milliseconds(timeout), ++m_shared->nextId);
+        auto& timers = m_shared->timers;
+        bool earliest = timers.empty() || id < timers.begin()->first;
+        timers.emplace(id, std::move(fn));
+        if (earliest) {
+            m_shared->cond.notify_one();
+        }
+        return id;
+    }
+
+    bool TimerService::cancel(const TimerId& id)
+    {
+        std::function<void()> fn;
+        std::lock_guard<std::mutex> lock(m_shared->mutex);
+        auto it = m_shared->timers.find(id);
+        if (it == m_shared->timers.end()) {
+            return false;
+        }
+        // destroyed once the lock is released, callbacks may own anything
+        fn = std::move(it->second);
+        m_shared->timers.erase(it);
+        return true;
+    }
+
+    void TimerService::run(std::shared_ptr<Shared> shared)
+    {
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        while (!shared->stop) {
+            if (shared->timers.empty()) {
+                shared->cond.wait(lock);
+                continue;
+            }
+            auto first = shared->timers.begin();
+            if (Clock::now() < first->first.first) {
+                shared->cond.wait_until(lock, first->first.first);
+                continue;
+            }
+            auto fn = std::move(first->second);
+            shared->timers.erase(first);
+            // callbacks may schedule or cancel timers themselves
+            lock.unlock();
+            fn();
+            fn = nullptr;
+            lock.lock();
+        }
+    }
+
+} // namespace CppNats
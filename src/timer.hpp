@@ -0,0 +1,64 @@
+/**
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace CppNats {
+
+    // One thread per client firing deadlines (request timeouts...), so pending
+    // operations never need a thread of their own. The thread is only started
+    // by the first schedule(). The service may be released from one of its own
+    // callbacks: the thread then finishes on its own instead of being joined.
+    class TimerService
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+            using TimerId = std::pair<Clock::time_point, uint64_t>;
+
+            TimerService();
+            // Pending timers are dropped without being fired.
+            ~TimerService();
+
+            TimerService(const TimerService&) = delete;
+            TimerService& operator=(const TimerService&) = delete;
+
+            // Runs fn on the timer thread after timeout milliseconds.
+            TimerId schedule(int timeout, std::function<void()> fn);
+            // Returns true if the timer was removed before it fired.
+            bool cancel(const TimerId& id);
+
+        private:
+            // Outlives the service when the thread has to finish on its own.
+            struct Shared
+            {
+                std::mutex mutex;
+                std::condition_variable cond;
+                std::map<TimerId, std::function<void()>> timers;
+                uint64_t nextId = 0;
+                bool stop = false;
+            };
+
+            static void run(std::shared_ptr<Shared> shared);
+
+            std::shared_ptr<Shared> m_shared;
+            std::thread m_thread;
+    };
+
+} // namespace CppNats
@@ -0,0 +1,89 @@
+/**
+ * @file workers.cpp
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under
+ * the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+#include <string_view>
+#include "workers.hpp"
+
+
+namespace CppNats {
+
+    WorkerPool::WorkerPool(std::size_t workers, std::size_t capacity, OverflowPolicy overflow, DispatchMode dispatch)
+        : m_dispatch(dispatch)
+    {
+        m_queues.reserve(workers);
+        for (std::size_t i = 0; i < workers; ++i) {
+            m_queues.push_back(std::make_unique<MessageQueue>(capacity, overflow));
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        close();
+        join();
+    }
+
+    void WorkerPool::start(Deliver deliver)
+    {
+        m_deliver = std::move(deliver);
+        m_threads.reserve(m_queues.size());
+        for (auto& queue : m_queues) {
+            m_threads.emplace_back(run, std::ref(*queue), std::cref(m_deliver));
+        }
+    }
+
+    MessageQueue& WorkerPool::queueFor(natsMsg* msg) noexcept
+    {
+        std::size_t index;
+        if (m_dispatch == DispatchMode::BySubject) {
+            index = std::hash<std::string_view>()(natsMsg_GetSubject(msg)) % m_queues.size();
+        } else {
+            index = m_next++ % m_queues.size();
+        }
+        return *m_queues[index];
+    }
+
+    void WorkerPool::close() noexcept
+    {
+        for (auto& queue : m_queues) {
+            queue->close();
+        }
+    }
+
+    void WorkerPool::join()
+    {
+        for (auto& thread : m_threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    void WorkerPool::run(MessageQueue& queue, const Deliver& deliver)
+    {
+        while (true) {
+            natsMsg* msg = queue.pop();
+            if (!msg) {
+                if (!queue.closed()) {
+                    queue.wait(1000);
+                    continue;
+                }
+                // closed: deliver what was pushed before close()
+                msg = queue.pop();
+                if (!msg) {
+                    return;
+                }
+            }
+            deliver(msg);
+        }
+    }
+
+} // namespace CppNats
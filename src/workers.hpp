@@ -0,0 +1,61 @@
+/**
+ * This file is part of CppNats, a C++ client for NATS.
+ *
+ * Copyright (C) 2026 Ludovic Leau Mercier
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http ://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+#include <nats.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "cppnats.hpp"
+#include "queue.hpp"
+
+namespace CppNats {
+
+    // Threads running the handler of one subscription. Each worker owns a
+    // MessageQueue fed by the cnats delivery thread, so every queue keeps a
+    // single producer and a single consumer.
+    class WorkerPool
+    {
+        public:
+            using Deliver = std::function<void(natsMsg*)>;
+
+            WorkerPool(std::size_t workers, std::size_t capacity, OverflowPolicy overflow, DispatchMode dispatch);
+            ~WorkerPool();
+
+            WorkerPool(const WorkerPool&) = delete;
+            WorkerPool& operator=(const WorkerPool&) = delete;
+
+            void start(Deliver deliver);
+
+            // Delivery thread only: the queue that should receive msg.
+            MessageQueue& queueFor(natsMsg* msg) noexcept;
+
+            // Stops the workers once they have delivered what is already queued.
+            void close() noexcept;
+            // Waits for the workers to stop, must not be called from one of them.
+            void join();
+
+            const std::vector<std::unique_ptr<MessageQueue>>& queues() const noexcept { return m_queues; }
+
+        private:
+            static void run(MessageQueue& queue, const Deliver& deliver);
+
+            const DispatchMode m_dispatch;
+            std::vector<std::unique_ptr<MessageQueue>> m_queues;
+            std::vector<std::thread> m_threads;
+            Deliver m_deliver;
+            // only touched by the delivery thread
+            std::size_t m_next = 0;
+    };
+
+} // namespace CppNats
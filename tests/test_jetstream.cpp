@@ -1,4 +1,10 @@
 #include <doctest/doctest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "test_helpers.h"
 
@@ -23,6 +29,292 @@ TEST_CASE_FIXTURE(JetStreamFixture, "connect to jetstream server") {
     c.close();
 }
 
-// TODO: add publish, subscribe, pull consumer tests
+TEST_CASE_FIXTURE(JetStreamFixture, "managing streams and publishing") {
+    CppNats::Client c;
+    c.connect(jsUrl);
+    auto js = c.jetStream();
+
+    CppNats::StreamConfig config;
+    config.name = "ORDERS";
+    config.subjects = {"orders.>"};
+    config.storage = CppNats::StorageType::Memory;
+    js.addStream(config);
+
+    CppNats::PubAck ack = js.publish("orders.new", "first");
+    CHECK(ack.stream == "ORDERS");
+    CHECK(ack.sequence == 1);
+    CHECK(js.publish(CppNats::Message("orders.new", "second")).sequence == 2);
+    CHECK(js.streamInfo("ORDERS").msgs == 2);
+
+    js.purgeStream("ORDERS");
+    CHECK(js.streamInfo("ORDERS").msgs == 0);
+    js.deleteStream("ORDERS");
+    CHECK_THROWS_AS(js.streamInfo("ORDERS"), CppNats::JetStreamException);
+    c.close();
+}
+
+TEST_CASE_FIXTURE(JetStreamFixture, "pipelined asynchronous publishing") {
+    CppNats::Client c;
+    c.connect(jsUrl);
+    CppNats::JetStreamOptions options;
+    options.maxPendingAcks = 16;
+    auto js = c.jetStream(options);
+
+    CppNats::StreamConfig config;
+    config.name = "EVENTS";
+    config.subjects = {"events.>"};
+    config.storage = CppNats::StorageType::Memory;
+    js.addStream(config);
+
+    constexpr int count = 500;
+    std::atomic<int> acked{0};
+    std::atomic<int> failed{0};
+    for (int i = 0; i < count; ++i) {
+        js.publishAsync("events.new", std::to_string(i), [&](const CppNats::PubAck& ack, const CppNats::JetStreamException* error) {
+            if (error || ack.stream != "EVENTS") {
+                failed++;
+            } else {
+                acked++;
+            }
+        });
+    }
+    js.waitForAcks(5000);
+    CHECK(js.pendingAcks() == 0);
+    CHECK(acked == count);
+    CHECK(failed == 0);
+    CHECK(js.streamInfo("EVENTS").msgs == count);
+
+    auto stored = js.publishAsync("events.new", "last");
+    CHECK(stored.get().sequence == count + 1);
+    auto lost = js.publishAsync("nowhere", "data");
+    CHECK_THROWS_AS(lost.get(), CppNats::JetStreamException);
+
+    js.deleteStream("EVENTS");
+    c.close();
+}
+
+TEST_CASE_FIXTURE(JetStreamFixture, "pull consumer batches") {
+    CppNats::Client c;
+    c.connect(jsUrl);
+    auto js = c.jetStream();
+
+    CppNats::StreamConfig config;
+    config.name = "WORK";
+    config.subjects = {"work.>"};
+    config.storage = CppNats::StorageType::Memory;
+    js.addStream(config);
+    for (int i = 0; i < 250; ++i) {
+        js.publishAsync("work.item", std::to_string(i), [](const CppNats::PubAck&, const CppNats::JetStreamException*) {});
+    }
+    js.waitForAcks(5000);
+
+    SUBCASE("explicit acks") {
+        CppNats::ConsumerConfig cc;
+        cc.durable = "explicit";
+        auto consumer = js.pullSubscribe("work.>", cc);
+        CppNats::FetchOptions fo;
+        fo.batch = 100;
+        fo.expires = 500;
+        std::vector<CppNats::Message> batch;
+        int next = 0;
+        while (consumer.fetch(batch, fo) > 0) {
+            for (auto& msg : batch) {
+                CHECK(msg.data() == std::to_string(next++));
+            }
+            consumer.ack(batch);
+        }
+        CHECK(next == 250);
+    }
+
+    SUBCASE("prefetch and ack all") {
+        CppNats::ConsumerConfig cc;
+        cc.ackPolicy = CppNats::AckPolicy::All;
+        cc.ackWait = 1000;
+        cc.prefetch = true;
+        auto consumer = js.pullSubscribe("work.>", cc);
+        CppNats::FetchOptions fo;
+        fo.batch = 64;
+        fo.expires = 500;
+        int next = 0;
+        for (auto batch = consumer.fetch(fo); !batch.empty(); batch = consumer.fetch(fo)) {
+            CHECK(batch.front().data() == std::to_string(next));
+            next += static_cast<int>(batch.size());
+            consumer.ack(batch);
+        }
+        CHECK(next == 250);
+        // acknowledged, so nothing comes back once the ack wait has passed
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        // the first batch was requested before the wait
+        CHECK(consumer.fetch(fo).empty());
+        CHECK(consumer.fetch(fo).empty());
+    }
+
+    js.deleteStream("WORK");
+    c.close();
+}
+
+TEST_CASE_FIXTURE(JetStreamFixture, "key-value bucket") {
+    CppNats::Client c;
+    c.connect(jsUrl);
+    auto js = c.jetStream();
+
+    CppNats::KeyValueConfig config;
+    config.bucket = "config";
+    config.history = 5;
+    config.storage = CppNats::StorageType::Memory;
+    auto kv = js.createKeyValue(config);
+
+    uint64_t first = kv.put("route.eu", "10.0.0.1");
+    CHECK(kv.get("route.eu")->value == "10.0.0.1");
+    CHECK(kv.get("route.us") == std::nullopt);
+    CHECK_THROWS_AS(kv.create("route.eu", "10.0.0.2"), CppNats::JetStreamException);
+    uint64_t second = kv.update("route.eu", "10.0.0.2", first);
+    CHECK(second > first);
+    CHECK_THROWS_AS(kv.update("route.eu", "10.0.0.3", first), CppNats::JetStreamException);
+
+    auto watcher = kv.watch("route.*");
+    CppNats::KeyValueEntry current = watcher.next(1000);
+    CHECK(current.key == "route.eu");
+    CHECK(current.revision == second);
+    CHECK(watcher.next(1000).revision == 0);
+    kv.remove("route.eu");
+    CHECK(watcher.next(1000).operation == CppNats::KeyValueOp::Delete);
+    CHECK(kv.get("route.eu") == std::nullopt);
+    watcher.stop();
+
+    js.deleteKeyValue("config");
+    c.close();
+}
+
+TEST_CASE_FIXTURE(JetStreamFixture, "key-value cache") {
+    CppNats::Client c;
+    c.connect(jsUrl);
+    auto js = c.jetStream();
+
+    CppNats::KeyValueConfig config;
+    config.bucket = "routes";
+    config.storage = CppNats::StorageType::Memory;
+    auto kv = js.createKeyValue(config);
+    kv.put("a", "1");
+    kv.put("b", "2");
+
+    kv.enableCache();
+    auto waitFor = [&](auto condition) {
+        for (int i = 0; i < 200 && !condition(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return condition();
+    };
+    REQUIRE(waitFor([&] { return kv.snapshot() != nullptr; }));
+    auto loaded = kv.snapshot();
+    CHECK(loaded->size() == 2);
+    CHECK(kv.get("a")->value == "1");
+
+    kv.put("a", "3");
+    kv.remove("b");
+    CHECK(waitFor([&] { auto e = kv.get("a"); return e && e->value == "3" && !kv.get("b"); }));
+    // an older snapshot is never modified
+    CHECK(loaded->at("a").value == "1");
+
+    js.deleteKeyValue("routes");
+    c.close();
+}
+
+TEST_CASE_FIXTURE(JetStreamFixture, "key-value cache refuses buckets with a ttl") {
+    CppNats::Client c;
+    c.connect(jsUrl);
+    auto js = c.jetStream();
+
+    CppNats::KeyValueConfig config;
+    config.bucket = "sessions";
+    config.storage = CppNats::StorageType::Memory;
+    config.ttl = 60000;
+    auto kv = js.createKeyValue(config);
+    CHECK_THROWS_AS(kv.enableCache(), CppNats::Exception);
+    CHECK(kv.snapshot() == nullptr);
+
+    js.deleteKeyValue("sessions");
+    c.close();
+}
+
+TEST_CASE_FIXTURE(JetStreamFixture, "object store") {
+    CppNats::Client c;
+    c.connect(jsUrl);
+    auto js = c.jetStream();
+
+    CppNats::ObjectStoreConfig config;
+    config.bucket = "blobs";
+    config.storage = CppNats::StorageType::Memory;
+    config.chunkSize = 1024;
+    config.window = 4;
+    auto store = js.createObjectStore(config);
+
+    std::string blob(10000, '\0');
+    for (std::size_t i = 0; i < blob.size(); ++i) {
+        blob[i] = static_cast<char>(i * 7);
+    }
+    CppNats::ObjectInfo info = store.put("build/artifact.bin", blob);
+    CHECK(info.size == blob.size());
+    CHECK(info.chunks == 10);
+    CHECK(store.info("build/artifact.bin")->nuid == info.nuid);
+    CHECK(info.digest.rfind("SHA-256=", 0) == 0);
+    CHECK(store.info("build/artifact.bin")->digest == info.digest);
+    CHECK(store.get("build/artifact.bin") == blob);
+
+    // the chunks of the previous version are removed
+    store.put("build/artifact.bin", std::string_view(blob).substr(0, 3000));
+    CHECK(js.streamInfo("OBJ_blobs").msgs == 3 + 1);
+
+    SUBCASE("streaming from and to files") {
+        FILE* in = std::tmpfile();
+        FILE* out = std::tmpfile();
+        REQUIRE(in);
+        REQUIRE(out);
+        std::fwrite(blob.data(), 1, blob.size(), in);
+        std::fflush(in);
+        std::rewind(in);
+        CHECK(store.putFile("file", fileno(in)).size == blob.size());
+        CHECK(store.getFile("file", fileno(out)).chunks == 10);
+        std::rewind(out);
+        std::string copy(blob.size(), '\0');
+        CHECK(std::fread(copy.data(), 1, copy.size(), out) == blob.size());
+        CHECK(copy == blob);
+        std::fclose(in);
+        std::fclose(out);
+    }
+
+    SUBCASE("malformed metadata") {
+        // "YmFk" is the base64url encoding of the name "bad"
+        js.publish("$O.blobs.M.YmFk", R"({"name":"b\u00zz","nuid":"x","size":1,"chunks":1})");
+        CHECK_THROWS_AS(store.info("bad"), CppNats::Exception);
+        js.publish("$O.blobs.M.YmFk", R"({"name":"b\u00)");
+        CHECK_THROWS_AS(store.info("bad"), CppNats::Exception);
+        js.publish("$O.blobs.M.YmFk", R"({"name":"b\x","nuid":"x","size":1,"chunks":1})");
+        CHECK_THROWS_AS(store.info("bad"), CppNats::Exception);
+        js.publish("$O.blobs.M.YmFk", R"({"name":"bad\)");
+        CHECK_THROWS_AS(store.info("bad"), CppNats::Exception);
+    }
+
+    SUBCASE("nested metadata members") {
+        js.publish("$O.blobs.M.YmFk",
+                   R"({"options":{"link":{"name":"other","nuid":"y"}},"name":"bad","nuid":"x","size":0,"chunks":0})");
+        auto info = store.info("bad");
+        REQUIRE(info.has_value());
+        CHECK(info->name == "bad");
+        CHECK(info->nuid == "x");
+    }
+
+    SUBCASE("removing objects") {
+        store.remove("build/artifact.bin");
+        CHECK_FALSE(store.info("build/artifact.bin").has_value());
+        CHECK_THROWS_AS(store.get("build/artifact.bin"), CppNats::Exception);
+        CHECK_THROWS_AS(store.remove("missing"), CppNats::Exception);
+    }
+
+    js.deleteObjectStore("blobs");
+    c.close();
+}
+
+// TODO: add push subscribe tests
 
 } // TEST_SUITE("jetstream")